@@ -0,0 +1,393 @@
+#include "fw16led/ledmatrix/ledmatrix.hpp"
+#include "fw16led/ledmatrix/marquee.hpp"
+#include "fw16led/ledmatrix/simulator.hpp"
+#include "fw16led/ledmatrix/text.hpp"
+#include "fw16led/ledmatrix/usbtransport.hpp"
+#include "fw16led/managers/audio.hpp"
+#include "fw16led/managers/sampler.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <libusb.h>
+#include <new>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+std::shared_ptr<spdlog::logger> logger_default;
+std::shared_ptr<fw16led::managers::UsbManager> usb_manager;
+std::shared_ptr<fw16led::PresetRegistry> preset_registry;
+std::shared_ptr<QSettings> settings;
+
+// Every heap allocation made by the process goes through these, so the benchmarks can count them
+namespace
+{
+  std::atomic<uint64_t> allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+namespace
+{
+  using namespace fw16led::ledmatrix;
+  using Clock = std::chrono::steady_clock;
+
+  constexpr int ENCODE_ITERATIONS = 1'000'000;
+  constexpr int SAMPLE_ITERATIONS = 1000;
+  constexpr auto THROUGHPUT_DURATION = std::chrono::seconds(2);
+
+  struct Options
+  {
+    bool device = false; /**< Run against the first connected panel instead of a simulated one. */
+    std::chrono::microseconds latency{0};
+    int roundTrips = 1000;
+  };
+
+  /**
+   * @brief Keep the compiler from optimizing the rendered frame away.
+   */
+  void consume(const Frame& frame)
+  {
+    asm volatile("" : : "r"(frame.data()) : "memory");
+  }
+
+  /**
+   * @brief Run a benchmark and print its cost per iteration.
+   * @return Whether it did not allocate.
+   */
+  template <typename F>
+  auto run(const char* name, int iterations, F&& body) -> bool
+  {
+    auto allocationsBefore = allocations.load();
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+      body(i);
+    }
+    auto elapsed = Clock::now() - start;
+    auto allocated = allocations.load() - allocationsBefore;
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::printf("%-28s %10.1f ns/call %8.3f allocations/call\n", name, ns, static_cast<double>(allocated) / iterations);
+    return allocated == 0;
+  }
+
+  void print_percentiles(const char* name, std::vector<double>& samples)
+  {
+    if (samples.empty())
+      return;
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double p)
+    { return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))]; };
+    std::printf("%-28s p50 %8.1f us  p90 %8.1f us  p99 %8.1f us  max %8.1f us\n", name, at(0.5), at(0.9), at(0.99), samples.back());
+  }
+
+  auto elapsed_us(Clock::time_point start) -> double
+  {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  }
+
+  auto parse_options(int argc, char** argv) -> std::optional<Options>
+  {
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string_view arg = argv[i];
+      if (arg == "--device")
+      {
+        options.device = true;
+      }
+      else if (arg == "--latency-us" && i + 1 < argc)
+      {
+        options.latency = std::chrono::microseconds(std::atoi(argv[++i]));
+      }
+      else if (arg == "--round-trips" && i + 1 < argc)
+      {
+        options.roundTrips = std::max(1, std::atoi(argv[++i]));
+      }
+      else
+      {
+        std::printf("Usage: %s [--device] [--latency-us N] [--round-trips N]\n", argv[0]);
+        return std::nullopt;
+      }
+    }
+    return options;
+  }
+
+  /**
+   * @brief Open and claim the first LED matrix, like UsbManager does.
+   */
+  auto open_device(libusb_context* context) -> libusb_device_handle*
+  {
+    libusb_device_handle* handle = libusb_open_device_with_vid_pid(context, VID, PID);
+    if (!handle)
+      return nullptr;
+
+#ifdef __linux__
+    if (libusb_kernel_driver_active(handle, 1) == 1)
+      libusb_detach_kernel_driver(handle, 1);
+#endif
+
+    if (libusb_claim_interface(handle, 1) != LIBUSB_SUCCESS)
+    {
+      libusb_close(handle);
+      return nullptr;
+    }
+    return handle;
+  }
+
+  auto bench_text() -> bool
+  {
+    bool ok = true;
+
+    ok &= run("render_text ascii", ENCODE_ITERATIONS, [](int)
+              {
+                Frame frame{};
+                render_text("12:34", frame);
+                consume(frame); });
+
+    ok &= run("render_text utf-8", ENCODE_ITERATIONS, [](int)
+              {
+                Frame frame{};
+                render_text("ÄÖÜ?!", frame);
+                consume(frame); });
+
+    ok &= run("render_symbols", ENCODE_ITERATIONS, [](int)
+              {
+                static constexpr std::array<std::string_view, 5> symbols = {"sun", "degC", "2", "1", ":)"};
+                Frame frame{};
+                render_symbols(symbols, frame);
+                consume(frame); });
+
+    Marquee marquee("THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG");
+    ok &= run("marquee step", ENCODE_ITERATIONS, [&](int i)
+              {
+                Frame frame{};
+                marquee.render(i, frame);
+                consume(frame); });
+
+    return ok;
+  }
+
+  auto bench_spectrum() -> bool
+  {
+    using fw16led::managers::Spectrum;
+    Spectrum spectrum(48000);
+    std::array<float, Spectrum::WINDOW> samples{};
+    for (size_t n = 0; n < samples.size(); ++n)
+      samples[n] = std::sin(0.1f * n) * 0.5f + std::sin(0.013f * n) * 0.25f;
+
+    Spectrum::Levels levels{};
+    return run("Spectrum::analyse", ENCODE_ITERATIONS / 100, [&](int)
+               {
+                 spectrum.analyse(samples, levels);
+                 asm volatile("" : : "r"(levels.data()) : "memory"); });
+  }
+
+  auto bench_sampler() -> bool
+  {
+    fw16led::managers::SystemSampler sampler;
+    sampler.sample();
+
+    auto start = Clock::now();
+    bool ok = run("SystemSampler::sample", SAMPLE_ITERATIONS, [&](int)
+                  { sampler.sample(); });
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count() / SAMPLE_ITERATIONS;
+    double interval = std::chrono::duration<double>(fw16led::managers::SystemSampler::SAMPLE_INTERVAL).count();
+    std::printf("%-28s %10.4f %% of a core\n", "sampling once per interval", 100.0 * seconds / interval);
+    return ok;
+  }
+
+  void bench_encode(LedMatrix& matrix)
+  {
+    // Inputs alternate so that no call is skipped as an unchanged frame
+    std::array<MatrixBitmap, 2> matrices{};
+    matrices[1].fill(true);
+    run("pattern_matrix", ENCODE_ITERATIONS / 10, [&](int i)
+        { matrix.pattern_matrix(matrices[i % 2]); });
+
+    std::array<std::array<std::string_view, 2>, 2> symbols = {{{"sun", "1"}, {"cloud", "2"}}};
+    run("pattern_symbols", ENCODE_ITERATIONS / 10, [&](int i)
+        { matrix.pattern_symbols(symbols[i % 2]); });
+
+    std::array<std::vector<uint8_t>, 2> levels = {std::vector<uint8_t>{1, 5, 9, 13, 17, 21, 25, 29, 33}, std::vector<uint8_t>{33, 29, 25, 21, 17, 13, 9, 5, 1}};
+    run("pattern_equalizer", ENCODE_ITERATIONS / 10, [&](int i)
+        { matrix.pattern_equalizer(levels[i % 2]); });
+  }
+
+  void bench_latency(LedMatrix& matrix, const Options& options)
+  {
+    std::vector<double> samples;
+    samples.reserve(options.roundTrips);
+
+    for (int i = 0; i < options.roundTrips; ++i)
+    {
+      auto start = Clock::now();
+      matrix.send_command(Command::Brightness, {static_cast<uint8_t>(i % 2 ? 100 : 101)});
+      samples.push_back(elapsed_us(start));
+
+      // Drain the queue now and then so commands are never dropped
+      if (i % (Transport::QUEUE_CAPACITY / 2) == 0)
+        matrix.send_command_with_response(Command::Brightness);
+    }
+    print_percentiles("send_command (enqueue)", samples);
+
+    samples.clear();
+    for (int i = 0; i < options.roundTrips; ++i)
+    {
+      auto start = Clock::now();
+      auto response = matrix.send_command_with_response(Command::Brightness);
+      if (!response.empty())
+        samples.push_back(elapsed_us(start));
+    }
+    print_percentiles("send_command_with_response", samples);
+    if (static_cast<int>(samples.size()) < options.roundTrips)
+      std::printf("%-28s %d of %d queries failed\n", "", options.roundTrips - static_cast<int>(samples.size()), options.roundTrips);
+
+    // Polling the whole device state, one query after another versus in one batch
+    samples.clear();
+    for (int i = 0; i < options.roundTrips; ++i)
+    {
+      auto start = Clock::now();
+      matrix.send_command_with_response(Command::Brightness);
+      matrix.send_command_with_response(Command::Animate);
+      matrix.send_command_with_response(Command::PwmFreq);
+      samples.push_back(elapsed_us(start));
+    }
+    print_percentiles("state, 3 queries", samples);
+
+    samples.clear();
+    for (int i = 0; i < options.roundTrips; ++i)
+    {
+      auto start = Clock::now();
+      matrix.refresh_state();
+      samples.push_back(elapsed_us(start));
+    }
+    print_percentiles("state, refresh_state", samples);
+
+    run("get_brightness (cached)", ENCODE_ITERATIONS, [&](int)
+        { asm volatile("" : : "r"(matrix.get_brightness())); });
+  }
+
+  void bench_throughput(LedMatrix& matrix)
+  {
+    // Queued frames are replaced by newer ones, so this measures how fast the device accepts frames
+    std::array<Frame, 2> frames{};
+    frames[1].fill(0xFF);
+
+    auto before = matrix.get_transport_stats();
+    auto start = Clock::now();
+    uint64_t submitted = 0;
+    while (Clock::now() - start < THROUGHPUT_DURATION)
+    {
+      matrix.draw(frames[submitted++ % 2]);
+    }
+
+    // Let the last frame reach the device
+    matrix.send_command_with_response(Command::Brightness);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    auto after = matrix.get_transport_stats();
+
+    // Counting by command leaves out the trailing query, and stays right if it never went out
+    auto sent = [&](Command command)
+    {
+      auto index = static_cast<size_t>(command);
+      return after.commandsSent[index] - before.commandsSent[index];
+    };
+    uint64_t packets = sent(Command::Draw);
+    uint64_t bytes = after.bytesSent - before.bytesSent - sent(Command::Brightness) * (FWK_MAGIG.size() + 1);
+    std::printf("%-28s %10.1f frames/s (%llu of %llu submitted frames sent)\n", "sustained Draw", packets / seconds, static_cast<unsigned long long>(packets), static_cast<unsigned long long>(submitted));
+    if (packets > 0)
+      std::printf("%-28s %10.1f bytes/frame\n", "bytes on the wire", static_cast<double>(bytes) / packets);
+    std::printf("%-28s %10llu retries, %llu timeouts, %llu failures\n", "transport errors", static_cast<unsigned long long>(after.retries - before.retries), static_cast<unsigned long long>(after.timeouts - before.timeouts), static_cast<unsigned long long>(after.failures - before.failures));
+    std::printf("%-28s p50 < %lld us  p99 < %lld us (whole run)\n", "command latency", static_cast<long long>(after.latency.percentile(0.5).count()), static_cast<long long>(after.latency.percentile(0.99).count()));
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  auto options = parse_options(argc, argv);
+  if (!options)
+    return EXIT_FAILURE;
+
+  logger_default = std::make_shared<spdlog::logger>("logger_default", std::make_shared<spdlog::sinks::stderr_color_sink_mt>());
+  logger_default->set_level(spdlog::level::warn);
+
+  // Benchmarks that must not allocate, in the order they run
+  std::vector<const char*> allocating;
+
+  std::printf("Text rendering\n");
+  if (!bench_text())
+    allocating.push_back("Text rendering");
+
+  std::printf("\nAudio spectrum\n");
+  if (!bench_spectrum())
+    allocating.push_back("Spectrum analysis");
+
+  std::printf("\nSystem sampler\n");
+  if (!bench_sampler())
+    allocating.push_back("System sampling");
+
+  libusb_context* context = nullptr;
+  if (int r = libusb_init(&context); r < 0)
+  {
+    std::printf("Failed to initialize libusb: %s\n", libusb_strerror(static_cast<libusb_error>(r)));
+    return EXIT_FAILURE;
+  }
+
+  {
+    TransferEngine engine(context);
+    std::unique_ptr<Transport> transport;
+    if (options->device)
+    {
+      libusb_device_handle* handle = open_device(context);
+      if (!handle)
+      {
+        std::printf("No LED matrix found\n");
+        return EXIT_FAILURE;
+      }
+      transport = std::make_unique<LibusbTransport>(handle, engine);
+      std::printf("\nTransport: LED matrix\n");
+    }
+    else
+    {
+      auto panel = std::make_shared<SimulatedPanel>();
+      panel->set_faults({.latency = options->latency});
+      transport = std::make_unique<SimulatedTransport>(panel, engine);
+      std::printf("\nTransport: simulated panel, %lld us latency\n", static_cast<long long>(options->latency.count()));
+    }
+
+    LedMatrix matrix(std::move(transport));
+    bench_encode(matrix);
+    bench_latency(matrix, *options);
+    bench_throughput(matrix);
+  }
+
+  libusb_exit(context);
+
+  for (const char* name : allocating)
+    std::printf("%s allocated memory\n", name);
+  return allocating.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ledmatrix/canvas.hpp"
+#include <chrono>
+#include <optional>
+
+namespace fw16led
+{
+  /**
+   * @brief Abstract base class for presets rendering across several panels at once.
+   *
+   * Unlike a Preset, which talks to a single LedMatrix, a canvas preset only draws into a
+   * Canvas. The PanelSpan splits every frame it renders between the panels and sends the parts
+   * in the same scheduler tick, so content can move from one panel to the next in lockstep.
+   */
+  class CanvasPreset
+  {
+  public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    virtual ~CanvasPreset() = default;
+
+    /**
+     * @brief Called before the first frame and whenever the number of panels changed.
+     * @param width Width of the canvas in pixels.
+     */
+    virtual void init(int width) = 0;
+
+    /**
+     * @brief Render the next frame into the canvas, which still holds the previous one.
+     * @param now Current time of the scheduler tick.
+     * @return When the preset wants to render again, or std::nullopt if its content is static.
+     */
+    virtual std::optional<TimePoint> render(TimePoint now, ledmatrix::Canvas& canvas) = 0;
+
+    virtual void exit() {}
+  };
+} // namespace fw16led
@@ -1,25 +1,156 @@
 #pragma once
 
 #include "fw16led/Preset.hpp"
+#include "fw16led/PresetOption.hpp"
+#include "fw16led/ledmatrix/framebuffer.hpp"
 #include "fw16led/ledmatrix/ledmatrix.hpp"
+#include "fw16led/ledmatrix/triplebuffer.hpp"
+#include "fw16led/managers/sharedframes.hpp"
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
 namespace fw16led
 {
+  /**
+   * @brief A connected LED matrix together with the preset rendering to it.
+   *
+   * The configuration is read on the GUI thread, while the preset is initialized, rendered and
+   * exited on the FrameScheduler's render thread, which is the only one talking to the matrix.
+   * Instead of a preset, the panel can also show frames streamed in by an external producer.
+   */
   class LedPanel
   {
   public:
-    LedPanel(std::shared_ptr<ledmatrix::LedMatrix> ledMatrix);
+    LedPanel(uint8_t id, std::shared_ptr<ledmatrix::LedMatrix> ledMatrix);
     ~LedPanel();
 
+    /**
+     * @brief Read the panel's settings and switch to the configured preset on the next tick.
+     */
     void applyConfig();
 
+    /**
+     * @brief Switch to a preset on the next tick without going through the settings.
+     * @param options Values of the preset's options, options that are missing keep their defaults.
+     * @param brightness New brightness, or std::nullopt to keep the current one.
+     * @return Whether the preset exists.
+     */
+    bool applyPreset(const std::string& presetId, const std::unordered_map<std::string, PresetOptionValue>& options, std::optional<uint8_t> brightness = std::nullopt);
+
+    /**
+     * @brief Change the brightness on the next tick, keeping the preset.
+     */
+    void setBrightness(uint8_t brightness);
+
+    /**
+     * @brief Show a frame instead of the preset's output.
+     *
+     * The preset is suspended until the next applyConfig() or applyPreset(). Frames shown faster
+     * than the panel is ticked replace each other. Must only be called by one thread at a time.
+     */
+    void showFrame(const ledmatrix::Frame& frame);
+
+    /**
+     * @brief Show a greyscale frame instead of the preset's output, see showFrame().
+     */
+    void showGreyFrame(const ledmatrix::Framebuffer& frame);
+
+    /**
+     * @brief Show this panel's part of a canvas right away, see PanelSpan.
+     *
+     * Suspends the preset like showFrame(), but sends the frame immediately. Must only be called
+     * on the render thread, outside of tick().
+     */
+    void showSpanned(const ledmatrix::Framebuffer& frame);
+
+    /**
+     * @brief Mark the panel as a member of an active span, see PanelSpan.
+     *
+     * While spanned, tick() holds back configurations passed in by applyConfig() and installs the
+     * newest one once the span releases the panel. Must only be called on the render thread.
+     */
+    inline void setSpanned(bool value) { spanned = value; }
+
+    /**
+     * @brief Show the frames a producer publishes into a shared memory ring, see showFrame().
+     *
+     * Replaces the ring attached before, the panel owns the ring from now on.
+     */
+    void attachSharedFrames(std::unique_ptr<managers::SharedFrameRing> ring);
+
+    /**
+     * @brief Name of the shared memory ring attached last, empty if there is none.
+     */
+    inline const std::string& getSharedFramesName() const { return sharedFramesName; }
+
+    /**
+     * @brief Render a frame if the preset is due and keep the panel awake if needed.
+     *
+     * Also installs a configuration passed in by applyConfig(). Must only be called by one thread at a time.
+     * @param now Time of the scheduler tick.
+     * @return When the panel needs to be ticked again, or std::nullopt if it can sleep.
+     */
+    auto tick(Preset::TimePoint now) -> std::optional<Preset::TimePoint>;
+
     inline uint8_t getId() const { return id; }
+    inline std::shared_ptr<ledmatrix::LedMatrix> getLedMatrix() const { return ledMatrix; }
 
   private:
+    /**
+     * @brief Configuration read by applyConfig(), waiting to be installed by tick().
+     *
+     * The preset is only created when it is installed, so configurations replaced before the
+     * next tick never construct one.
+     */
+    struct PendingConfig
+    {
+      std::string presetId;
+      std::unordered_map<std::string, PresetOptionValue> options;
+      std::optional<uint8_t> brightness;
+    };
+
+    /**
+     * @brief Frame handed in by showFrame() or showGreyFrame().
+     */
+    struct StreamedFrame
+    {
+      uint32_t generation = 0; /**< Frames of an older generation were superseded by a preset. */
+      bool grey = false;
+      ledmatrix::Frame frame{};
+      ledmatrix::Framebuffer greyFrame;
+    };
+
+    void install(PendingConfig config, Preset::TimePoint now);
+    void publish(StreamedFrame& frame);
+    void show(const StreamedFrame& frame);
+    void suspendPreset();
+    void checkFirstFrame();
+
     uint8_t id;
     std::shared_ptr<Preset> currentPreset = nullptr;
     std::shared_ptr<ledmatrix::LedMatrix> ledMatrix;
+    std::optional<Preset::TimePoint> nextFrame; /**< When the preset wants to render next. */
+
+    std::mutex configMutex;
+    std::optional<PendingConfig> pendingConfig;
+    std::optional<uint8_t> pendingBrightness;
+    std::unique_ptr<managers::SharedFrameRing> pendingSharedFrames;
+    std::string sharedFramesName;
+
+    ledmatrix::TripleBuffer<StreamedFrame> streamedFrames;
+    std::atomic<uint32_t> generation = 0; /**< Bumped by every new preset, see StreamedFrame. */
+    uint32_t installedGeneration = 0;     /**< Generation of the preset installed by tick(). */
+    bool streaming = false;               /**< Whether tick() shows streamed frames instead of rendering the preset. */
+    bool spanned = false;                 /**< Whether an active span shows its canvas on this panel. */
+    bool firstFrameSent = false;          /**< Whether the time to the first frame was logged already. */
+
+    std::unique_ptr<managers::SharedFrameRing> sharedFrames;
+    uint32_t sharedFramesSeen = 0; /**< Frames published into the ring before this were shown or superseded. */
+    StreamedFrame sharedFrame;     /**< Newest frame taken from the ring. */
   };
 } // namespace fw16led
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "PresetDescriptor.hpp"
 #include "PresetOption.hpp"
 #include "ledmatrix/ledmatrix.hpp"
+#include <chrono>
+#include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 namespace fw16led
@@ -18,6 +23,8 @@ namespace fw16led
   class Preset
   {
   public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
     Preset(const std::string& id, const std::string& displayName)
       : id_(id)
       , displayName_(displayName)
@@ -28,105 +35,120 @@ namespace fw16led
     virtual void init(std::shared_ptr<ledmatrix::LedMatrix> panel) = 0;
     virtual void exit() = 0;
 
+    /**
+     * @brief Render the next frame.
+     *
+     * Called by the FrameScheduler right after init() and then whenever the time returned by the
+     * previous call has come.
+     * @param now Current time of the scheduler tick.
+     * @return When the preset wants to render again, or std::nullopt if its content is static.
+     */
+    virtual std::optional<TimePoint> render([[maybe_unused]] TimePoint now)
+    {
+      return std::nullopt;
+    }
+
+    /**
+     * @brief Whether the panel has to be kept from falling asleep while this preset is active.
+     */
+    virtual bool keepsAwake() const
+    {
+      return true;
+    }
+
     const std::string& getId() const { return id_; }
     const std::string& getDisplayName() const { return displayName_; }
 
-    virtual std::vector<PresetOptionConfig> getOptions() const
+    /**
+     * @brief The preset's options, empty unless the preset was created by the PresetRegistry.
+     */
+    const std::vector<PresetOptionConfig>& getOptions() const
+    {
+      static const std::vector<PresetOptionConfig> none;
+      return descriptor_ ? descriptor_->options : none;
+    }
+
+    /**
+     * @brief Position of an option, which reads it through getOptionValue(size_t) without looking up its key.
+     * @return The position, or std::nullopt if the preset has no such option.
+     */
+    std::optional<size_t> getOptionIndex(std::string_view key) const
     {
-      std::vector<PresetOptionConfig> options;
-      return options;
+      return descriptor_ ? descriptor_->indexOf(key) : std::nullopt;
     }
 
     /**
      * @brief Set the value for a given preset option.
-     * @param key The option's unique key.
+     * @param key The option's unique key, values for keys the preset does not have are ignored.
      * @param value The new value for the option.
      */
-    void setOptionValue(const std::string& key, PresetOptionValue value)
+    void setOptionValue(std::string_view key, PresetOptionValue value)
     {
-      configValues_[key] = value;
+      if (auto index = getOptionIndex(key))
+        values_[*index] = std::move(value);
     }
 
     /**
      * @brief Get the current value of a preset option.
      * @param key The option's unique key.
-     * @return An optional containing the value if set, or std::nullopt otherwise.
+     * @return An optional containing the value, or std::nullopt if the preset has no such option.
      */
-    std::optional<PresetOptionValue> getOptionValue(const std::string& key) const
+    std::optional<PresetOptionValue> getOptionValue(std::string_view key) const
     {
-      auto it = configValues_.find(key);
-      if (it != configValues_.end())
-      {
-        return it->second;
-      }
-      for (const auto& option : getOptions())
-      {
-        if (option.key == key)
-        {
-          if (option.type == PresetOptionType::NumberRange)
-          {
-            return option.defaultNumber;
-          }
-          else if (option.type == PresetOptionType::Text)
-          {
-            return option.defaultText;
-          }
-          else if (option.type == PresetOptionType::Dropdown)
-          {
-            return option.dropdownOptions[0].key;
-          }
-          else if (option.type == PresetOptionType::Checkbox)
-          {
-            return option.defaultBool;
-          }
-        }
-      }
+      if (auto index = getOptionIndex(key))
+        return values_[*index];
+      return std::nullopt;
+    }
+
+    template <typename T>
+    std::optional<T> getOptionValue(std::string_view key) const
+    {
+      if (auto index = getOptionIndex(key))
+        return getOptionValue<T>(*index);
       return std::nullopt;
     }
 
+    /**
+     * @brief Get the current value of the option at a position returned by getOptionIndex().
+     *
+     * Numbers are converted between int and double, any other type mismatch gives std::nullopt.
+     */
     template <typename T>
-    std::optional<T> getOptionValue(const std::string& key) const
+    std::optional<T> getOptionValue(size_t index) const
     {
       static_assert(std::is_same_v<T, std::string> || std::is_same_v<T, double> || std::is_same_v<T, int> || std::is_same_v<T, bool>, "T can only be string, double, int or bool");
-      auto it = configValues_.find(key);
-      if (it != configValues_.end())
-      {
-        return std::get<T>(it->second);
-      }
-      for (const auto& option : getOptions())
+      if (index >= values_.size())
+        return std::nullopt;
+
+      const auto& value = values_[index];
+      if (const T* exact = std::get_if<T>(&value))
+        return *exact;
+      if constexpr (std::is_same_v<T, double> || std::is_same_v<T, int>)
       {
-        if (option.key == key)
-        {
-          switch (option.type)
-          {
-          case PresetOptionType::NumberRange:
-            if constexpr (std::is_same_v<T, double> || std::is_same_v<T, int>)
-              return std::optional<T>(static_cast<T>(option.defaultNumber));
-            break;
-          case PresetOptionType::Text:
-            if constexpr (std::is_same_v<T, std::string>)
-              return std::optional<T>(option.defaultText);
-            break;
-          case PresetOptionType::Dropdown:
-            if constexpr (std::is_same_v<T, int>)
-              return std::optional<T>(option.dropdownOptions[0].key);
-            break;
-          case PresetOptionType::Checkbox:
-            if constexpr (std::is_same_v<T, bool>)
-              return std::optional<T>(option.defaultBool);
-            break;
-          default:
-            break;
-          }
-        }
+        if (const double* number = std::get_if<double>(&value))
+          return static_cast<T>(*number);
+        if (const int* number = std::get_if<int>(&value))
+          return static_cast<T>(*number);
       }
       return std::nullopt;
     }
 
   private:
+    friend class PresetRegistry;
+
+    /**
+     * @brief Called by the PresetRegistry right after creating the preset, resets all options to their defaults.
+     */
+    void setDescriptor(std::shared_ptr<const PresetDescriptor> descriptor)
+    {
+      descriptor_ = std::move(descriptor);
+      values_ = descriptor_->defaults;
+    }
+
     std::string id_;
     std::string displayName_;
-    std::unordered_map<std::string, PresetOptionValue> configValues_;
+    std::shared_ptr<const PresetDescriptor> descriptor_;
+    std::vector<PresetOptionValue> values_; /**< Value of every option, by position in the descriptor. */
   };
 
 } // namespace fw16led
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "PresetOption.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fw16led
+{
+  class Preset;
+
+  /**
+   * @brief Hash allowing string maps to be searched with a std::string_view, without building a std::string.
+   */
+  struct StringHash
+  {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+  };
+
+  /**
+   * @brief Everything known about a registered preset, built once when it is registered.
+   *
+   * Descriptors are never changed afterwards, so references to them and their options stay valid
+   * as long as the registry exists and can be shared between threads. Options are addressed by
+   * their position in options, which presets can look up once and then use for every read.
+   */
+  struct PresetDescriptor
+  {
+    using Creator = std::function<std::unique_ptr<Preset>()>;
+
+    PresetDescriptor(std::string id, std::string displayName, Creator creator, std::vector<PresetOptionConfig> options)
+      : id(std::move(id))
+      , displayName(std::move(displayName))
+      , creator(std::move(creator))
+      , options(std::move(options))
+    {
+      defaults.reserve(this->options.size());
+      for (size_t i = 0; i < this->options.size(); ++i)
+      {
+        indices.emplace(this->options[i].key, i);
+        defaults.push_back(defaultValue(this->options[i]));
+      }
+    }
+
+    /**
+     * @brief Position of an option in options, or std::nullopt if the preset has no such option.
+     */
+    auto indexOf(std::string_view key) const -> std::optional<size_t>
+    {
+      auto it = indices.find(key);
+      if (it == indices.end())
+        return std::nullopt;
+      return it->second;
+    }
+
+    /**
+     * @brief Value a preset uses for an option that was never set.
+     */
+    static auto defaultValue(const PresetOptionConfig& option) -> PresetOptionValue
+    {
+      switch (option.type)
+      {
+      case PresetOptionType::NumberRange:
+        return option.defaultNumber;
+      case PresetOptionType::Text:
+        return option.defaultText;
+      case PresetOptionType::Dropdown:
+        return option.dropdownOptions.empty() ? option.defaultDropdown : option.dropdownOptions[0].key;
+      case PresetOptionType::Checkbox:
+        return option.defaultBool;
+      }
+      return {};
+    }
+
+    const std::string id;
+    const std::string displayName;
+    const Creator creator;
+    const std::vector<PresetOptionConfig> options;
+    std::vector<PresetOptionValue> defaults;                                  /**< Default value of every option, by position. */
+    std::unordered_map<std::string, size_t, StringHash, std::equal_to<>> indices; /**< Position of every option, by key. */
+  };
+} // namespace fw16led
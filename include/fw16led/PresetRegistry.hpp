@@ -1,9 +1,11 @@
 #pragma once
 
 #include "Preset.hpp"
+#include "PresetDescriptor.hpp"
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -21,79 +23,83 @@ namespace fw16led
     /**
      * @brief Type alias for the preset creator function.
      */
-    using PresetCreator = std::function<std::unique_ptr<Preset>()>;
+    using PresetCreator = PresetDescriptor::Creator;
 
     PresetRegistry() {};
 
     /**
      * @brief Register a preset with a unique id, its creator, and a display name.
+     *
+     * Presets are registered at startup, before any other thread uses the registry.
      * @param id Unique identifier for the preset.
      * @param creator Function that creates an instance of the preset.
      * @param displayName Display name for the preset.
      */
     void registerPreset(const std::string& id, const std::string& displayName, PresetCreator creator, std::vector<PresetOptionConfig> options)
     {
-      creators_[id] = creator;
-      displayNames_[id] = displayName;
-      options_[id] = options;
+      auto [it, inserted] = descriptors_.insert_or_assign(id, std::make_shared<const PresetDescriptor>(id, displayName, std::move(creator), std::move(options)));
+      if (inserted)
+        ids_.push_back(id);
+    }
+
+    /**
+     * @brief Get the descriptor of a preset.
+     * @param id Unique identifier of the preset.
+     * @return The descriptor, or nullptr if not found.
+     */
+    const PresetDescriptor* find(std::string_view id) const
+    {
+      auto it = descriptors_.find(id);
+      return it != descriptors_.end() ? it->second.get() : nullptr;
     }
 
     /**
      * @brief Get the display name of a preset based on its unique id.
      * @param id Unique identifier of the preset.
-     * @return Display name of the preset, or an empty string if not found.
+     * @return Display name of the preset, or "?" if not found.
      */
-    std::string getDisplayName(const std::string& id) const
+    const std::string& getDisplayName(std::string_view id) const
     {
-      if (displayNames_.find(id) != displayNames_.end())
-      {
-        return displayNames_.at(id);
-      }
-      return "?";
+      static const std::string unknown = "?";
+      const auto* descriptor = find(id);
+      return descriptor ? descriptor->displayName : unknown;
     }
 
-    std::vector<PresetOptionConfig>& getOptions(const std::string& id)
+    const std::vector<PresetOptionConfig>& getOptions(std::string_view id) const
     {
-      if (options_.find(id) != options_.end())
-      {
-        return options_.at(id);
-      }
-      return empty;
+      static const std::vector<PresetOptionConfig> none;
+      const auto* descriptor = find(id);
+      return descriptor ? descriptor->options : none;
     }
 
     /**
      * @brief Create a preset based on its unique id.
      * @param id Unique identifier of the preset.
-     * @return A unique_ptr to the created preset, or nullptr if not found.
+     * @return A unique_ptr to the created preset with all options at their defaults, or nullptr if not found.
      */
-    std::unique_ptr<Preset> createPreset(const std::string& id)
+    std::unique_ptr<Preset> createPreset(std::string_view id) const
     {
-      if (creators_.find(id) != creators_.end())
-      {
-        return creators_[id]();
-      }
-      return nullptr;
+      auto it = descriptors_.find(id);
+      if (it == descriptors_.end())
+        return nullptr;
+
+      auto preset = it->second->creator();
+      preset->setDescriptor(it->second);
+      return preset;
     }
 
     /**
      * @brief Get a list of all registered preset ids.
-     * @return Vector containing all registered preset ids.
+     * @return All registered preset ids, in the order they were registered.
      */
-    std::vector<std::string> getRegisteredPresetIds() const
+    const std::vector<std::string>& getRegisteredPresetIds() const
     {
-      std::vector<std::string> ids;
-      for (const auto& entry : creators_)
-      {
-        ids.push_back(entry.first);
-      }
-      return ids;
+      return ids_;
     }
 
   private:
-    std::unordered_map<std::string, PresetCreator> creators_;                  /**< Map of preset ids to their creator functions. */
-    std::unordered_map<std::string, std::string> displayNames_;                /**< Map of preset ids to their display names. */
-    std::unordered_map<std::string, std::vector<PresetOptionConfig>> options_; /**< Map of preset ids to their options. */
-    std::vector<PresetOptionConfig> empty;                                     /**< Empty vector to return if no options are found. */
+    std::unordered_map<std::string, std::shared_ptr<const PresetDescriptor>, StringHash, std::equal_to<>> descriptors_; /**< Map of preset ids to their descriptors. */
+    std::vector<std::string> ids_;                                                                                      /**< Preset ids in registration order. */
   };
 
 } // namespace fw16led
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <QSettings>
+#include <chrono>
 #include <spdlog/spdlog.h>
 
 // Forward declaration of UsbManager
 namespace fw16led::managers
 {
   class UsbManager;
+  class SystemSampler;
 }
 
 // Forward declaration of PresetRegistry
@@ -19,6 +21,8 @@ extern std::shared_ptr<spdlog::logger> logger_default;
 extern std::shared_ptr<fw16led::managers::UsbManager> usb_manager;
 extern std::shared_ptr<fw16led::PresetRegistry> preset_registry;
 extern std::shared_ptr<QSettings> settings;
+extern std::shared_ptr<fw16led::managers::SystemSampler> system_sampler;
+extern const std::chrono::steady_clock::time_point startup_time;
 
 #define LOG_TRACE(...) SPDLOG_LOGGER_TRACE(logger_default, __VA_ARGS__)
 #define LOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(logger_default, __VA_ARGS__)
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "fw16led/ledmatrix/framebuffer.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Kind of frames stored in an animation file.
+   */
+  enum class AnimationFormat : uint8_t
+  {
+    Bits = 0, /**< FRAME_SIZE bytes per frame, the Command::Draw payload. */
+    Grey = 1, /**< PIXELS bytes per frame, column by column like Framebuffer. */
+  };
+
+  /**
+   * @brief Start of an animation file, followed by frameCount AnimationFrameEntry and the frame data.
+   *
+   * All fields are little endian. Frames are stored exactly as they are sent, so playing them
+   * back is a matter of pointing at the right offset of the file.
+   */
+  struct AnimationHeader
+  {
+    static constexpr std::array<char, 4> MAGIC = {'F', 'W', 'A', 'N'};
+    static constexpr uint16_t VERSION = 1;
+
+    std::array<char, 4> magic = MAGIC;
+    uint16_t version = VERSION;
+    AnimationFormat format = AnimationFormat::Bits;
+    uint8_t reserved = 0;
+    uint32_t frameCount = 0;
+    uint32_t reserved2 = 0;
+  };
+
+  struct AnimationFrameEntry
+  {
+    uint32_t offset = 0;     /**< Position of the frame data from the start of the file. */
+    uint16_t durationMs = 0; /**< How long the frame is shown, at least 1 ms. */
+    uint16_t reserved = 0;
+  };
+
+  static_assert(sizeof(AnimationHeader) == 16);
+  static_assert(sizeof(AnimationFrameEntry) == 8);
+
+  /**
+   * @brief Frames of an animation file in memory, usually a mapping of the file.
+   *
+   * Only the header and the frame table are checked when the view is created, frame data is
+   * not touched until it is shown, so the pages of long animations are only read when they are
+   * needed. Frames are returned as references into the memory without copying or decoding.
+   * The memory has to outlive the view.
+   */
+  class AnimationView
+  {
+  public:
+    /**
+     * @brief Check the header and frame table.
+     * @return The view, or std::nullopt if the data is not a valid animation.
+     */
+    static auto parse(std::span<const uint8_t> data) -> std::optional<AnimationView>;
+
+    auto get_format() const -> AnimationFormat { return format; }
+    auto frame_count() const -> size_t { return frameCount; }
+    auto duration(size_t index) const -> std::chrono::milliseconds;
+
+    /**
+     * @brief Frame of a Bits animation.
+     */
+    auto bits(size_t index) const -> const Frame&;
+
+    /**
+     * @brief Frame of a Grey animation.
+     */
+    auto grey(size_t index) const -> const Framebuffer&;
+
+  private:
+    auto entry(size_t index) const -> AnimationFrameEntry;
+
+    std::span<const uint8_t> data;
+    AnimationFormat format = AnimationFormat::Bits;
+    size_t frameCount = 0;
+  };
+
+  /**
+   * @brief Builds an animation file in memory.
+   *
+   * Frames that were added before are stored only once and referenced by every entry showing
+   * them, and a frame repeating the previous one only extends its duration. Both cost nothing
+   * on playback, unlike a delta or run-length encoding that would have to be decoded.
+   */
+  class AnimationWriter
+  {
+  public:
+    explicit AnimationWriter(AnimationFormat format);
+
+    void add(const Frame& frame, std::chrono::milliseconds duration);
+    void add(const Framebuffer& framebuffer, std::chrono::milliseconds duration);
+
+    auto frame_count() const -> size_t { return entries.size(); }
+
+    /**
+     * @brief The complete file.
+     */
+    auto finish() const -> std::vector<uint8_t>;
+
+  private:
+    void append(std::span<const uint8_t> frame, std::chrono::milliseconds duration);
+
+    AnimationFormat format;
+    std::vector<AnimationFrameEntry> entries; /**< Offsets relative to the start of frames. */
+    std::vector<uint8_t> frames;
+    std::unordered_multimap<size_t, uint32_t> offsetsByHash;
+  };
+} // namespace fw16led::ledmatrix
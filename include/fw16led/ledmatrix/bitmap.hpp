@@ -0,0 +1,257 @@
+#pragma once
+
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief 1-bit image stored in the layout of the Command::Draw payload.
+   *
+   * Bit i of the byte array is the pixel at x + y * W, so a bitmap of the matrix size can be
+   * sent as it is. Operations work on whole bytes or 64-bit words instead of single pixels.
+   * Padding bits after the last pixel are always zero.
+   */
+  template <int W, int H>
+  class Bitmap
+  {
+    static_assert(W > 0 && W <= 57, "Rows have to fit into a 64-bit word at any bit offset");
+    static_assert(H > 0);
+
+  public:
+    static constexpr int PIXELS = W * H;
+    static constexpr int BYTES = (PIXELS + 7) / 8;
+    using Storage = std::array<uint8_t, BYTES>;
+
+    constexpr Bitmap() = default;
+
+    /**
+     * @brief Create a bitmap from bytes in Draw layout.
+     */
+    static constexpr auto from_bytes(std::span<const uint8_t, BYTES> bytes) -> Bitmap
+    {
+      Bitmap bitmap;
+      std::copy(bytes.begin(), bytes.end(), bitmap.bytes.begin());
+      bitmap.clear_padding();
+      return bitmap;
+    }
+
+    constexpr auto get(int x, int y) const -> bool
+    {
+      int i = x + y * W;
+      return (bytes[i / 8] >> (i % 8)) & 1;
+    }
+
+    constexpr void set(int x, int y, bool on = true)
+    {
+      int i = x + y * W;
+      if (on)
+        bytes[i / 8] |= 1 << (i % 8);
+      else
+        bytes[i / 8] &= ~(1 << (i % 8));
+    }
+
+    constexpr void fill(bool on)
+    {
+      bytes.fill(on ? 0xFF : 0x00);
+      clear_padding();
+    }
+
+    /**
+     * @brief Set or clear a rectangle, clipped to the bitmap.
+     */
+    constexpr void fill_rect(int x, int y, int width, int height, bool on = true)
+    {
+      int left = std::max(x, 0);
+      int right = std::min(x + width, W);
+      if (left >= right)
+        return;
+
+      uint64_t mask = ((uint64_t(1) << (right - left)) - 1) << left;
+      for (int row = std::max(y, 0); row < std::min(y + height, H); ++row)
+      {
+        uint64_t bits = read_row(row);
+        write_row(row, on ? bits | mask : bits & ~mask);
+      }
+    }
+
+    /**
+     * @brief Copy another bitmap into this one with its top left corner at (x, y), clipped to the bitmap.
+     */
+    template <int SW, int SH>
+    constexpr void blit(const Bitmap<SW, SH>& source, int x, int y)
+    {
+      int left = std::max(x, 0);
+      int right = std::min(x + SW, W);
+      if (left >= right)
+        return;
+
+      uint64_t mask = ((uint64_t(1) << (right - left)) - 1) << left;
+      for (int row = std::max(y, 0); row < std::min(y + SH, H); ++row)
+      {
+        uint64_t bits = source.read_row(row - y);
+        bits = x >= 0 ? bits << x : bits >> -x;
+        write_row(row, (read_row(row) & ~mask) | (bits & mask));
+      }
+    }
+
+    /**
+     * @brief Move the contents by dx columns to the right and dy rows down. Pixels moved out are lost,
+     * uncovered pixels are cleared.
+     */
+    constexpr void shift(int dx, int dy)
+    {
+      if (dx <= -W || dx >= W || dy <= -H || dy >= H)
+      {
+        fill(false);
+        return;
+      }
+
+      // In Draw layout moving by whole rows is a shift of the whole bit string
+      shift_bits(dx + dy * W);
+
+      // Pixels shifted past the end of a row wrapped into the neighbouring row
+      if (dx > 0)
+        fill_rect(0, 0, dx, H, false);
+      else if (dx < 0)
+        fill_rect(W + dx, 0, -dx, H, false);
+    }
+
+    constexpr auto operator|=(const Bitmap& other) -> Bitmap&
+    {
+      combine(other, [](uint64_t a, uint64_t b)
+              { return a | b; });
+      return *this;
+    }
+
+    constexpr auto operator&=(const Bitmap& other) -> Bitmap&
+    {
+      combine(other, [](uint64_t a, uint64_t b)
+              { return a & b; });
+      return *this;
+    }
+
+    constexpr auto operator^=(const Bitmap& other) -> Bitmap&
+    {
+      combine(other, [](uint64_t a, uint64_t b)
+              { return a ^ b; });
+      return *this;
+    }
+
+    friend constexpr auto operator|(Bitmap a, const Bitmap& b) -> Bitmap { return a |= b; }
+    friend constexpr auto operator&(Bitmap a, const Bitmap& b) -> Bitmap { return a &= b; }
+    friend constexpr auto operator^(Bitmap a, const Bitmap& b) -> Bitmap { return a ^= b; }
+
+    constexpr auto operator~() const -> Bitmap
+    {
+      Bitmap inverted;
+      for (int i = 0; i < BYTES; ++i)
+        inverted.bytes[i] = ~bytes[i];
+      inverted.clear_padding();
+      return inverted;
+    }
+
+    constexpr bool operator==(const Bitmap& other) const = default;
+
+    /**
+     * @brief The pixels in Draw layout.
+     */
+    constexpr auto data() const -> const Storage& { return bytes; }
+
+    /**
+     * @brief The W pixels of a row, the leftmost one in the lowest bit.
+     */
+    constexpr auto read_row(int y) const -> uint64_t
+    {
+      int first = y * W;
+      uint64_t bits = 0;
+      for (int i = first / 8, shift = 0; i <= (first + W - 1) / 8; ++i, shift += 8)
+        bits |= uint64_t(bytes[i]) << shift;
+      return (bits >> (first % 8)) & ROW_MASK;
+    }
+
+    constexpr void write_row(int y, uint64_t bits)
+    {
+      int first = y * W;
+      uint64_t mask = ROW_MASK << (first % 8);
+      bits = (bits & ROW_MASK) << (first % 8);
+      for (int i = first / 8, shift = 0; i <= (first + W - 1) / 8; ++i, shift += 8)
+        bytes[i] = static_cast<uint8_t>((bytes[i] & ~(mask >> shift)) | (bits >> shift));
+    }
+
+  private:
+    static constexpr uint64_t ROW_MASK = (uint64_t(1) << W) - 1;
+
+    template <typename Op>
+    constexpr void combine(const Bitmap& other, Op op)
+    {
+      int i = 0;
+      if (!std::is_constant_evaluated())
+      {
+        for (; i + 8 <= BYTES; i += 8)
+        {
+          uint64_t a, b;
+          std::memcpy(&a, bytes.data() + i, 8);
+          std::memcpy(&b, other.bytes.data() + i, 8);
+          a = op(a, b);
+          std::memcpy(bytes.data() + i, &a, 8);
+        }
+      }
+      for (; i < BYTES; ++i)
+        bytes[i] = static_cast<uint8_t>(op(bytes[i], other.bytes[i]));
+    }
+
+    /**
+     * @brief Shift the bit string towards higher (positive) or lower (negative) pixel indices.
+     */
+    constexpr void shift_bits(int count)
+    {
+      int byteShift = (count < 0 ? -count : count) / 8;
+      int bitShift = (count < 0 ? -count : count) % 8;
+      Storage shifted{};
+
+      for (int i = 0; i < BYTES; ++i)
+      {
+        if (count > 0)
+        {
+          int source = i - byteShift;
+          if (source >= 0)
+            shifted[i] = static_cast<uint8_t>(bytes[source] << bitShift);
+          if (bitShift && source - 1 >= 0)
+            shifted[i] |= bytes[source - 1] >> (8 - bitShift);
+        }
+        else
+        {
+          int source = i + byteShift;
+          if (source < BYTES)
+            shifted[i] = static_cast<uint8_t>(bytes[source] >> bitShift);
+          if (bitShift && source + 1 < BYTES)
+            shifted[i] |= static_cast<uint8_t>(bytes[source + 1] << (8 - bitShift));
+        }
+      }
+
+      bytes = shifted;
+      clear_padding();
+    }
+
+    constexpr void clear_padding()
+    {
+      if constexpr (PIXELS % 8 != 0)
+        bytes[BYTES - 1] &= (1 << (PIXELS % 8)) - 1;
+    }
+
+    template <int, int>
+    friend class Bitmap;
+
+    Storage bytes{};
+  };
+
+  /**
+   * @brief A bitmap covering the whole matrix, whose data() is a Frame.
+   */
+  using MatrixBitmap = Bitmap<WIDTH, HEIGHT>;
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "fw16led/ledmatrix/framebuffer.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Greyscale image spanning several matrices placed side by side.
+   *
+   * The canvas is WIDTH columns per panel wide and HEIGHT rows high. Like Framebuffer, pixels are
+   * stored column by column, so the part shown by one panel is a contiguous range that is copied
+   * into its Framebuffer as is.
+   */
+  class Canvas
+  {
+  public:
+    Canvas()
+      : Canvas(1)
+    {
+    }
+
+    explicit Canvas(int panels)
+      : panels(panels)
+      , pixels(static_cast<size_t>(panels) * PIXELS, 0)
+    {
+    }
+
+    auto panel_count() const -> int { return panels; }
+    auto width() const -> int { return panels * WIDTH; }
+
+    auto at(int x, int y) -> uint8_t& { return pixels[x * HEIGHT + y]; }
+    auto at(int x, int y) const -> uint8_t { return pixels[x * HEIGHT + y]; }
+
+    void fill(uint8_t value) { std::ranges::fill(pixels, value); }
+
+    /**
+     * @brief Copy the part of the canvas shown by a panel, counting panels from the left.
+     */
+    void copy_panel(int panel, Framebuffer& framebuffer) const
+    {
+      const uint8_t* columns = pixels.data() + static_cast<size_t>(panel) * PIXELS;
+      for (int x = 0; x < WIDTH; ++x)
+      {
+        for (int y = 0; y < HEIGHT; ++y)
+          framebuffer.at(x, y) = columns[x * HEIGHT + y];
+      }
+    }
+
+  private:
+    int panels;
+    std::vector<uint8_t> pixels;
+  };
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <libusb.h>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Dedicated I/O thread running the libusb event loop.
+   *
+   * All asynchronous transfer completions of the context are dispatched on this thread,
+   * keeping USB traffic off the Qt GUI thread. Work that has to happen later on the same
+   * thread (e.g. retrying a transfer after a backoff) can be scheduled with post_at().
+   */
+  class TransferEngine
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using TaskId = uint64_t;
+
+    TransferEngine(libusb_context* context);
+    ~TransferEngine();
+
+    TransferEngine(const TransferEngine&) = delete;
+    TransferEngine& operator=(const TransferEngine&) = delete;
+
+    /**
+     * @brief Run a task on the I/O thread once the given time has been reached.
+     * @return Id that can be passed to cancel().
+     */
+    auto post_at(Clock::time_point when, std::function<void()> task) -> TaskId;
+
+    /**
+     * @brief Remove a task that has not started running yet.
+     * @return Whether the task was removed; false if it already ran or is running right now.
+     */
+    auto cancel(TaskId id) -> bool;
+
+  private:
+    struct Task
+    {
+      TaskId id;
+      std::function<void()> run;
+    };
+
+    void run();
+    void run_due_tasks();
+
+    libusb_context* context;
+    std::atomic<bool> running = true;
+
+    std::mutex mutex;
+    std::multimap<Clock::time_point, Task> tasks; /**< Pending tasks ordered by due time. */
+    TaskId nextTaskId = 1;
+
+    std::thread thread;
+  };
+} // namespace fw16led::ledmatrix
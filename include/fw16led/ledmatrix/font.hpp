@@ -1,9 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
-#include <memory>
-#include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <string_view>
 
 namespace fw16led::ledmatrix
 {
@@ -11,85 +11,146 @@ namespace fw16led::ledmatrix
   inline constexpr int FONT_HEIGHT = 6;
   inline constexpr int FONT_PIXELS = FONT_WIDTH * FONT_HEIGHT;
 
-  using FontMap = std::unordered_map<std::string_view, std::array<bool, FONT_PIXELS>>;
-  const std::unique_ptr<const FontMap> FONT_MAP = std::make_unique<const FontMap>(FontMap{
-      {"0", {false, true, true, false, false, true, false, false, true, false, true, false, false, true, false, true, false, false, true, false, true, false, false, true, false, false, true, true, false, false}},
-      {"1", {false, false, true, false, false, false, true, true, false, false, true, false, true, false, false, false, false, true, false, false, false, false, true, false, false, true, true, true, true, true}},
-      {"2", {true, true, true, true, false, false, false, false, false, true, true, true, true, true, true, true, false, false, false, false, true, false, false, false, false, true, true, true, true, true}},
-      {"3", {true, true, true, true, false, false, false, false, false, true, true, true, true, true, true, false, false, false, false, true, false, false, false, false, true, true, true, true, true, false}},
-      {"4", {false, false, false, true, false, false, false, true, true, false, false, true, false, true, false, true, true, true, true, true, false, false, false, true, false, false, false, false, true, false}},
-      {"5", {true, true, true, true, true, true, false, false, false, false, true, true, true, true, true, false, false, false, false, true, false, false, false, false, true, true, true, true, true, false}},
-      {"6", {false, true, true, true, false, true, false, false, false, false, true, true, true, true, true, true, false, false, false, true, true, false, false, false, true, false, true, true, true, false}},
-      {"7", {true, true, true, true, true, false, false, false, false, true, false, false, false, true, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false}},
-      {"8", {false, true, true, true, false, true, false, false, false, true, false, true, true, true, false, true, false, false, false, true, true, false, false, false, true, false, true, true, true, false}},
-      {"9", {false, true, true, true, false, true, false, false, false, true, true, true, true, true, true, false, false, false, false, true, false, false, false, false, true, false, true, true, true, false}},
-      {":", {false, false, false, false, false, false, false, false, false, false, false, false, true, false, false, false, false, false, false, false, false, false, true, false, false, false, false, false, false, false}},
-      {" ", {false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false}},
-      {"?", {false, true, true, false, false, false, false, false, true, false, false, false, false, true, false, false, false, true, false, false, false, false, false, false, false, false, false, true, false, false}},
-      {".", {false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, true, false, false, false, false, false, false, false, false, false, false, false, false}},
-      {",", {false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, true, false, false, false, false, false, false, false, false, false, false, false, false}},
-      {"!", {false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, false, false, false, false, false, true, false, false}},
-      {"/", {false, false, false, false, true, false, false, false, true, true, false, false, true, true, false, false, true, true, false, false, true, true, false, false, false, true, false, false, false, false}},
-      {"*", {false, false, false, false, false, false, true, false, true, false, false, false, true, false, false, false, true, false, true, false, false, false, false, false, false, false, false, false, false, false}},
-      {"%", {true, true, false, false, true, true, true, false, true, true, false, false, true, true, false, false, true, true, false, false, true, true, false, true, true, true, false, false, true, true}},
-      {"+", {false, false, true, false, false, false, false, true, false, false, true, true, true, true, true, false, false, true, false, false, false, false, true, false, false, false, false, false, false, false}},
-      {"-", {false, false, false, false, false, false, false, false, false, false, true, true, true, true, true, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false}},
-      {"=", {false, false, false, false, false, true, true, true, true, true, false, false, false, false, false, true, true, true, true, true, false, false, false, false, false, false, false, false, false, false}},
-      {"A", {false, true, true, true, false, true, false, false, false, true, true, true, true, true, true, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true}},
-      {"B", {true, true, true, true, false, true, false, false, false, true, true, true, true, true, false, true, false, false, false, true, true, false, false, false, true, true, true, true, true, false}},
-      {"C", {true, true, true, true, true, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, true, true, true, true}},
-      {"D", {true, true, true, true, false, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, true, true, true, true, false}},
-      {"E", {true, true, true, true, true, true, false, false, false, false, true, true, true, true, true, true, false, false, false, false, true, false, false, false, false, true, true, true, true, true}},
-      {"F", {true, true, true, true, true, true, false, false, false, false, true, true, true, true, true, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false}},
-      {"G", {false, true, true, true, false, true, false, false, false, false, true, false, true, true, true, true, false, false, false, true, true, false, false, false, true, false, true, true, true, false}},
-      {"H", {true, false, false, false, true, true, false, false, false, true, true, true, true, true, true, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true}},
-      {"I", {false, true, true, true, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, true, true, true, false}},
-      {"J", {false, true, true, true, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, true, false, false, true, false, false, true, true, false}},
-      {"K", {true, false, false, true, false, true, false, true, false, false, true, true, false, false, false, true, false, true, false, false, true, false, false, true, false, true, false, false, false, true}},
-      {"L", {true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, true, true, true, true}},
-      {"M", {false, false, false, false, false, false, true, false, true, false, true, false, true, false, true, true, false, true, false, true, true, false, true, false, true, true, false, true, false, true}},
-      {"N", {true, false, false, false, true, true, true, false, false, true, true, false, true, false, true, true, false, true, false, true, true, false, true, false, true, true, false, false, true, true}},
-      {"O", {false, true, true, true, false, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, false, true, true, true, false}},
-      {"P", {true, true, true, false, false, true, false, false, true, false, true, false, false, true, false, true, true, true, false, false, true, false, false, false, false, true, false, false, false, false}},
-      {"Q", {false, true, true, true, false, true, false, false, false, true, true, false, false, false, true, true, false, true, false, true, true, false, false, true, false, false, true, true, false, true}},
-      {"R", {true, true, true, true, false, true, false, false, true, false, true, true, true, true, false, true, true, false, false, false, true, false, true, false, false, true, false, false, true, false}},
-      {"S", {true, true, true, true, true, true, false, false, false, false, false, true, true, true, false, false, false, false, false, true, false, false, false, false, true, true, true, true, true, false}},
-      {"T", {true, true, true, true, true, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false, false, false, true, false, false}},
-      {"U", {true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, true, true, true, true, true}},
-      {"V", {true, false, false, false, true, true, false, false, false, true, false, true, false, true, true, false, true, false, true, true, false, false, true, false, false, false, false, true, false, false}},
-      {"W", {true, false, false, false, true, true, false, false, false, true, true, false, true, false, true, true, false, true, false, true, false, true, false, true, false, false, true, false, true, false}},
-      {"X", {true, false, false, false, true, false, true, false, true, false, false, false, true, false, false, false, false, true, false, false, false, true, false, true, false, true, false, false, false, true}},
-      {"Y", {true, false, false, false, true, true, false, false, false, true, false, true, false, true, false, false, true, false, true, false, false, false, true, false, false, false, false, true, false, false}},
-      {"Z", {true, true, true, true, true, false, false, false, true, false, false, false, true, false, false, false, true, false, false, false, true, false, false, false, false, true, true, true, true, true}},
-      {"Ä", {false, true, false, true, false, false, false, false, false, false, true, true, true, true, true, true, false, false, false, true, true, true, true, true, true, true, false, false, false, true}},
-      {"Ö", {false, true, false, true, false, false, false, false, false, false, false, true, true, true, false, true, false, false, false, true, true, false, false, false, true, false, true, true, true, false}},
-      {"Ü", {false, true, false, true, false, false, false, false, false, false, true, false, false, false, true, true, false, false, false, true, true, false, false, false, true, true, true, true, true, true}},
-      {"degC", {true, true, false, false, false, true, true, false, false, false, false, false, true, true, true, false, false, true, false, false, false, false, true, false, false, false, false, true, true, true}},
-      {"degF", {true, true, false, false, false, true, true, false, false, false, false, false, true, true, true, false, false, true, false, false, false, false, true, true, true, false, false, true, false, false}},
-      {"snow", {false, false, false, false, false, true, false, true, false, true, false, true, true, true, false, true, true, true, true, true, false, true, true, true, false, true, false, true, false, true}},
-      {"sun", {false, false, false, false, false, false, true, true, true, false, true, true, true, true, true, true, true, true, true, true, true, true, true, true, true, false, true, true, true, false}},
-      {"cloud", {false, false, false, false, false, false, true, true, true, false, true, true, true, true, true, true, true, true, true, true, false, false, false, false, false, false, false, false, false, false}},
-      {"rain", {false, true, true, true, false, true, true, true, true, true, true, true, true, true, true, false, true, false, false, true, false, false, true, false, false, true, false, false, true, false}},
-      {"thunder", {false, true, true, true, false, true, true, true, true, true, true, true, true, true, true, false, false, true, false, false, false, true, false, false, false, false, false, true, false, false}},
-      {"batteryLow", {false, false, false, false, false, false, false, false, false, false, true, true, true, true, false, true, false, false, true, true, true, false, false, true, true, true, true, true, true, false}},
-      {"!!", {false, true, false, true, false, false, true, false, true, false, false, true, false, true, false, false, false, false, false, false, false, true, false, true, false, false, true, false, true, false}},
-      {"j", {false, false, false, false, false, true, true, false, true, true, true, true, true, true, true, false, true, true, true, false, false, false, true, false, false, false, false, false, false, false}},
-      {"heart0", {true, true, false, true, true, true, true, true, true, true, false, true, true, true, false, false, false, true, false, false, false, false, false, false, false, false, false, false, false, false}},
-      {"heart2", {false, false, false, false, false, false, false, false, false, false, true, true, false, true, true, true, true, true, true, true, false, true, true, true, false, false, false, true, false, false}},
-      {":)", {false, false, false, false, false, false, true, false, true, false, false, false, false, false, false, false, false, false, false, false, true, false, false, false, true, false, true, true, true, false}},
-      {":|", {false, false, false, false, false, false, true, false, true, false, false, false, false, false, false, false, false, false, false, false, true, true, true, true, true, false, false, false, false, false}},
-      {":(", {false, false, false, false, false, false, true, false, true, false, false, false, false, false, false, false, false, false, false, false, false, true, true, true, false, true, false, false, false, true}},
-      {";)", {false, false, false, false, false, true, true, false, true, false, false, false, false, false, false, false, false, false, false, false, true, false, false, false, true, false, true, true, true, false}}});
-
-  auto get_char(const std::string& c) -> const std::array<bool, FONT_PIXELS>&
+  /**
+   * @brief A glyph stored as one byte per row, the most significant of the FONT_WIDTH bits being the leftmost pixel.
+   */
+  using Glyph = std::array<uint8_t, FONT_HEIGHT>;
+
+  constexpr auto glyph_pixel(const Glyph& glyph, int x, int y) -> bool
   {
-    if (auto it = FONT_MAP->find(c); it != FONT_MAP->end())
-    {
-      return it->second;
-    }
-    else
+    return (glyph[y] >> (FONT_WIDTH - 1 - x)) & 1;
+  }
+
+  struct CharGlyph
+  {
+    char32_t codePoint;
+    Glyph glyph;
+  };
+
+  struct NamedGlyph
+  {
+    std::string_view name;
+    Glyph glyph;
+  };
+
+  inline constexpr auto CHAR_GLYPHS = std::to_array<CharGlyph>({
+      {U'0', {0b01100, 0b10010, 0b10010, 0b10010, 0b10010, 0b01100}},
+      {U'1', {0b00100, 0b01100, 0b10100, 0b00100, 0b00100, 0b11111}},
+      {U'2', {0b11110, 0b00001, 0b11111, 0b10000, 0b10000, 0b11111}},
+      {U'3', {0b11110, 0b00001, 0b11111, 0b00001, 0b00001, 0b11110}},
+      {U'4', {0b00010, 0b00110, 0b01010, 0b11111, 0b00010, 0b00010}},
+      {U'5', {0b11111, 0b10000, 0b11111, 0b00001, 0b00001, 0b11110}},
+      {U'6', {0b01110, 0b10000, 0b11111, 0b10001, 0b10001, 0b01110}},
+      {U'7', {0b11111, 0b00001, 0b00010, 0b00100, 0b00100, 0b00100}},
+      {U'8', {0b01110, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110}},
+      {U'9', {0b01110, 0b10001, 0b11111, 0b00001, 0b00001, 0b01110}},
+      {U':', {0b00000, 0b00000, 0b00100, 0b00000, 0b00100, 0b00000}},
+      {U' ', {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000}},
+      {U'?', {0b01100, 0b00010, 0b00010, 0b00100, 0b00000, 0b00100}},
+      {U'.', {0b00000, 0b00000, 0b00000, 0b00100, 0b00000, 0b00000}},
+      {U',', {0b00000, 0b00000, 0b00000, 0b00100, 0b00000, 0b00000}},
+      {U'!', {0b00100, 0b00100, 0b00100, 0b00100, 0b00000, 0b00100}},
+      {U'/', {0b00001, 0b00011, 0b00110, 0b01100, 0b11000, 0b10000}},
+      {U'*', {0b00000, 0b01010, 0b00100, 0b01010, 0b00000, 0b00000}},
+      {U'%', {0b11001, 0b11011, 0b00110, 0b01100, 0b11011, 0b10011}},
+      {U'+', {0b00100, 0b00100, 0b11111, 0b00100, 0b00100, 0b00000}},
+      {U'-', {0b00000, 0b00000, 0b11111, 0b00000, 0b00000, 0b00000}},
+      {U'=', {0b00000, 0b11111, 0b00000, 0b11111, 0b00000, 0b00000}},
+      {U'A', {0b01110, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001}},
+      {U'B', {0b11110, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110}},
+      {U'C', {0b11111, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111}},
+      {U'D', {0b11110, 0b10001, 0b10001, 0b10001, 0b10001, 0b11110}},
+      {U'E', {0b11111, 0b10000, 0b11111, 0b10000, 0b10000, 0b11111}},
+      {U'F', {0b11111, 0b10000, 0b11111, 0b10000, 0b10000, 0b10000}},
+      {U'G', {0b01110, 0b10000, 0b10111, 0b10001, 0b10001, 0b01110}},
+      {U'H', {0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001}},
+      {U'I', {0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110}},
+      {U'J', {0b01111, 0b00001, 0b00001, 0b00001, 0b01001, 0b00110}},
+      {U'K', {0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001}},
+      {U'L', {0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111}},
+      {U'M', {0b00000, 0b01010, 0b10101, 0b10101, 0b10101, 0b10101}},
+      {U'N', {0b10001, 0b11001, 0b10101, 0b10101, 0b10101, 0b10011}},
+      {U'O', {0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110}},
+      {U'P', {0b11100, 0b10010, 0b10010, 0b11100, 0b10000, 0b10000}},
+      {U'Q', {0b01110, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101}},
+      {U'R', {0b11110, 0b10010, 0b11110, 0b11000, 0b10100, 0b10010}},
+      {U'S', {0b11111, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110}},
+      {U'T', {0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100}},
+      {U'U', {0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b11111}},
+      {U'V', {0b10001, 0b10001, 0b01011, 0b01011, 0b00100, 0b00100}},
+      {U'W', {0b10001, 0b10001, 0b10101, 0b10101, 0b01010, 0b01010}},
+      {U'X', {0b10001, 0b01010, 0b00100, 0b00100, 0b01010, 0b10001}},
+      {U'Y', {0b10001, 0b10001, 0b01010, 0b01010, 0b00100, 0b00100}},
+      {U'Z', {0b11111, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111}},
+      {U'\u00C4', {0b01010, 0b00000, 0b11111, 0b10001, 0b11111, 0b10001}}, // Ä
+      {U'\u00D6', {0b01010, 0b00000, 0b01110, 0b10001, 0b10001, 0b01110}}, // Ö
+      {U'\u00DC', {0b01010, 0b00000, 0b10001, 0b10001, 0b10001, 0b11111}}, // Ü
+      {U'j', {0b00000, 0b11011, 0b11111, 0b01110, 0b00100, 0b00000}},
+  });
+
+  /**
+   * @brief Symbols that do not correspond to a single character and are selected by name.
+   */
+  inline constexpr auto NAMED_GLYPHS = std::to_array<NamedGlyph>({
+      {"degC", {0b11000, 0b11000, 0b00111, 0b00100, 0b00100, 0b00111}},
+      {"degF", {0b11000, 0b11000, 0b00111, 0b00100, 0b00111, 0b00100}},
+      {"snow", {0b00000, 0b10101, 0b01110, 0b11111, 0b01110, 0b10101}},
+      {"sun", {0b00000, 0b01110, 0b11111, 0b11111, 0b11111, 0b01110}},
+      {"cloud", {0b00000, 0b01110, 0b11111, 0b11111, 0b00000, 0b00000}},
+      {"rain", {0b01110, 0b11111, 0b11111, 0b01001, 0b00100, 0b10010}},
+      {"thunder", {0b01110, 0b11111, 0b11111, 0b00100, 0b01000, 0b00100}},
+      {"batteryLow", {0b00000, 0b00000, 0b11110, 0b10011, 0b10011, 0b11110}},
+      {"!!", {0b01010, 0b01010, 0b01010, 0b00000, 0b01010, 0b01010}},
+      {"heart0", {0b11011, 0b11111, 0b01110, 0b00100, 0b00000, 0b00000}},
+      {"heart2", {0b00000, 0b00000, 0b11011, 0b11111, 0b01110, 0b00100}},
+      {":)", {0b00000, 0b01010, 0b00000, 0b00000, 0b10001, 0b01110}},
+      {":|", {0b00000, 0b01010, 0b00000, 0b00000, 0b11111, 0b00000}},
+      {":(", {0b00000, 0b01010, 0b00000, 0b00000, 0b01110, 0b10001}},
+      {";)", {0b00000, 0b11010, 0b00000, 0b00000, 0b10001, 0b01110}},
+  });
+
+  inline constexpr char32_t FIRST_GLYPH_CODE_POINT = 0x20;
+  inline constexpr char32_t LAST_GLYPH_CODE_POINT = 0xFF;
+  inline constexpr char32_t FALLBACK_CODE_POINT = U'?';
+
+  /**
+   * @brief Glyphs indexed by code point, starting at FIRST_GLYPH_CODE_POINT. Characters without a glyph show the fallback.
+   */
+  inline constexpr auto GLYPH_TABLE = []()
+  {
+    const auto fallback = std::ranges::find(CHAR_GLYPHS, FALLBACK_CODE_POINT, &CharGlyph::codePoint)->glyph;
+
+    std::array<Glyph, LAST_GLYPH_CODE_POINT - FIRST_GLYPH_CODE_POINT + 1> table{};
+    table.fill(fallback);
+    for (const auto& [codePoint, glyph] : CHAR_GLYPHS)
     {
-      return FONT_MAP->at("?");
+      table[codePoint - FIRST_GLYPH_CODE_POINT] = glyph;
     }
+    return table;
+  }();
+
+  constexpr auto get_char(char32_t codePoint) -> const Glyph&
+  {
+    if (codePoint < FIRST_GLYPH_CODE_POINT || codePoint > LAST_GLYPH_CODE_POINT)
+      codePoint = FALLBACK_CODE_POINT;
+    return GLYPH_TABLE[codePoint - FIRST_GLYPH_CODE_POINT];
+  }
+
+  /**
+   * @brief Look up a symbol by name, or a single character given as UTF-8.
+   */
+  constexpr auto get_char(std::string_view symbol) -> const Glyph&
+  {
+    if (symbol.size() == 1)
+      return get_char(static_cast<char32_t>(static_cast<unsigned char>(symbol[0])));
+
+    // Two byte sequences cover everything up to LAST_GLYPH_CODE_POINT
+    if (symbol.size() == 2 && (symbol[0] & 0xE0) == 0xC0 && (symbol[1] & 0xC0) == 0x80)
+      return get_char(static_cast<char32_t>(((symbol[0] & 0x1F) << 6) | (symbol[1] & 0x3F)));
+
+    if (auto it = std::ranges::find(NAMED_GLYPHS, symbol, &NamedGlyph::name); it != NAMED_GLYPHS.end())
+      return it->glyph;
+
+    return get_char(FALLBACK_CODE_POINT);
   }
 } // namespace fw16led::ledmatrix
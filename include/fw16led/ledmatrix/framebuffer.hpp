@@ -0,0 +1,50 @@
+#pragma once
+
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Greyscale image for the whole matrix with one brightness byte per pixel.
+   *
+   * Pixels are stored column by column, which is the layout the device expects for
+   * Command::StageGreyCol, so a column can be sent without any conversion.
+   */
+  class Framebuffer
+  {
+  public:
+    constexpr Framebuffer() = default;
+
+    constexpr auto at(int x, int y) -> uint8_t& { return pixels[x * HEIGHT + y]; }
+    constexpr auto at(int x, int y) const -> uint8_t { return pixels[x * HEIGHT + y]; }
+
+    constexpr void fill(uint8_t value) { pixels.fill(value); }
+
+    /**
+     * @brief Brightness values of a column from top to bottom.
+     */
+    auto column(int x) const -> std::span<const uint8_t, HEIGHT>
+    {
+      return std::span<const uint8_t, HEIGHT>(pixels.data() + x * HEIGHT, HEIGHT);
+    }
+
+    auto column_equals(const Framebuffer& other, int x) const -> bool
+    {
+      return std::equal(pixels.begin() + x * HEIGHT, pixels.begin() + (x + 1) * HEIGHT, other.pixels.begin() + x * HEIGHT);
+    }
+
+    /**
+     * @brief All pixels in storage order.
+     */
+    constexpr auto data() const -> const std::array<uint8_t, PIXELS>& { return pixels; }
+
+    constexpr bool operator==(const Framebuffer& other) const = default;
+
+  private:
+    std::array<uint8_t, PIXELS> pixels{};
+  };
+} // namespace fw16led::ledmatrix
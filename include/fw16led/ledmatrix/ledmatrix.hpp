@@ -1,89 +1,145 @@
 #pragma once
 
 #include "fw16led/global.hpp"
+#include "fw16led/ledmatrix/bitmap.hpp"
+#include "fw16led/ledmatrix/framebuffer.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include "fw16led/ledmatrix/transport.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <future>
 #include <libusb.h>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
 #include <vector>
 
 namespace fw16led::ledmatrix
 {
-  enum class Command : uint8_t
+  /**
+   * @brief Identical frames are still sent once this much time passed since the last transfer,
+   * so that skipping them never lets the panel fall asleep.
+   */
+  constexpr auto KEEP_ALIVE_INTERVAL = std::chrono::seconds(30);
+
+  /**
+   * @brief How long the blocking query functions wait for a response before giving up.
+   */
+  constexpr auto RESPONSE_TIMEOUT = std::chrono::milliseconds(500);
+
+  /**
+   * @brief Counters describing how many Draw frames actually reached the device.
+   */
+  struct FrameStats
   {
-    Brightness = 0x00,
-    Pattern = 0x01,
-    BootloaderReset = 0x02,
-    Sleep = 0x03,
-    Animate = 0x04,
-    Panic = 0x05,
-    Draw = 0x06,
-    StageGreyCol = 0x07,
-    DrawGreyColBuffer = 0x08,
-    SetText = 0x09,
-    StartGame = 0x10,
-    GameControl = 0x11,
-    GameStatus = 0x12,
-    SetColor = 0x13,
-    DisplayOn = 0x14,
-    InvertScreen = 0x15,
-    SetPixelColumn = 0x16,
-    FlushFramebuffer = 0x17,
-    ClearRam = 0x18,
-    ScreenSaver = 0x19,
-    SetFps = 0x1A,
-    SetPowerMode = 0x1B,
-    PwmFreq = 0x1E,
-    DebugMode = 0x1F,
-    Version = 0x20,
+    uint64_t sent = 0;   /**< Frames transferred to the device. */
+    uint64_t elided = 0; /**< Frames skipped because the panel was already showing them. */
   };
 
-  enum class IntegratedPattern : uint8_t
+  /**
+   * @brief Everything that is counted about the traffic of a panel.
+   */
+  struct PanelMetrics
   {
-    Percentage = 0x00,
-    Gradient = 0x01,
-    DoubleGradient = 0x02,
-    DisplayLotus = 0x03,
-    ZigZag = 0x04,
-    FullBrightness = 0x05,
-    DisplayPanic = 0x06,
-    DisplayLotus2 = 0x07,
+    TransportStats transport;
+    FrameStats frames;
   };
 
-  constexpr unsigned int VID = 0x32AC;
-  constexpr unsigned int PID = 0x0020;
-
-  constexpr int WIDTH = 9;
-  constexpr int HEIGHT = 34;
-  constexpr int PIXELS = WIDTH * HEIGHT;
+  /**
+   * @brief What is known about the device's settings, each value being unset until it was read or written.
+   */
+  struct DeviceState
+  {
+    std::optional<uint8_t> brightness;
+    std::optional<bool> animating;
+    std::optional<int> pwmFreq; /**< In Hz. */
+    std::optional<bool> sleeping;
+  };
 
   class LedMatrix
   {
   private:
-    std::unique_ptr<libusb_device_handle, decltype(&libusb_close)> device;
+    std::atomic<bool> greyCommitFailed = false; /**< Set by the transport, declared first so that it outlives the transport's callbacks. */
+    std::unique_ptr<Transport> transport;
+
+    std::optional<Frame> lastFrame;                      /**< Frame the panel is currently showing, if known. */
+    std::chrono::steady_clock::time_point lastTransfer; /**< Time of the last command sent to the device. */
+    std::atomic<uint64_t> framesSent = 0;   /**< See FrameStats, atomic so that they can be read from any thread. */
+    std::atomic<uint64_t> framesElided = 0;
+
+    std::optional<Framebuffer> stagedGrey; /**< Contents of the device's greyscale column buffer, if known. */
+    std::optional<Framebuffer> shownGrey;  /**< Greyscale image the panel is currently showing, if known. */
+
+    mutable std::mutex stateMutex;
+    DeviceState deviceState; /**< Mirror of the device's settings, updated from our own writes and from replies. Guarded by stateMutex. */
+
+    void track_command(Command command, std::span<const uint8_t> parameters);
+    void record_response(Command command, std::span<const uint8_t> response);
 
   public:
-    LedMatrix(libusb_device_handle* device)
-      : device(device, libusb_close)
+    explicit LedMatrix(std::unique_ptr<Transport> transport)
+      : transport(std::move(transport))
     {
     }
 
-    ~LedMatrix();
-
+    /**
+     * @brief Queue a command for the device without waiting for it to be sent.
+     */
     void send_command(Command command, const std::vector<uint8_t>& parameters = {});
+
+    /**
+     * @brief Send a command and block until its response arrived or RESPONSE_TIMEOUT expired.
+     * @return The response, or an empty vector on failure.
+     */
     auto send_command_with_response(Command command, const std::vector<uint8_t>& parameters = {}) -> std::vector<uint8_t>;
 
+    /**
+     * @brief Send a command and return a future resolving to its response.
+     */
+    auto query(Command command, const std::vector<uint8_t>& parameters = {}) -> std::future<std::vector<uint8_t>>;
+
+    /**
+     * @brief Send a command and pass its response to a callback running on the USB event thread.
+     */
+    void query(Command command, const std::vector<uint8_t>& parameters, Transport::ResponseCallback onResponse);
+
+    /**
+     * @brief Send several queries back to back and block until all of them were answered or
+     * RESPONSE_TIMEOUT expired.
+     * @return The responses in the order of the commands, empty ones for queries that failed.
+     */
+    auto query_batch(std::span<const Command> commands) -> std::vector<std::vector<uint8_t>>;
+
+    /**
+     * @brief Read brightness, animation and PWM frequency from the device in one batch.
+     * @return The updated device state.
+     */
+    auto refresh_state() -> DeviceState;
+
+    /**
+     * @brief Snapshot of the device state as far as it is known, without talking to the device.
+     * Can be called from any thread.
+     */
+    auto get_state() const -> DeviceState
+    {
+      std::lock_guard lock(stateMutex);
+      return deviceState;
+    }
+
     void animate(bool animate = true)
     {
       LOG_TRACE("Setting integrated animate to {}", animate);
       this->send_command(Command::Animate, {static_cast<uint8_t>(animate ? 0x01 : 0x00)});
     }
 
-    auto get_animate() -> bool
-    {
-      LOG_TRACE("Getting current animation status");
-      auto res = this->send_command_with_response(Command::Animate);
-      return !res.empty() && res[0] == 0x01;
-    }
+    /**
+     * @brief Whether the integrated animation is running. Only reads the device if the state is not known yet.
+     */
+    auto get_animate() -> bool;
 
     void pattern_full_brightness()
     {
@@ -141,21 +197,39 @@ namespace fw16led::ledmatrix
     void pattern_empty_matrix()
     {
       LOG_TRACE("Setting pattern to empty matrix");
-      std::vector<bool> matrix(PIXELS, false);
-      this->pattern_matrix(matrix);
+      this->pattern_matrix(MatrixBitmap{});
     }
 
-    void pattern_text(const std::string& text);
+    void pattern_text(std::string_view text);
 
-    void pattern_symbols(std::vector<std::string>& parts);
+    void pattern_symbols(std::span<const std::string_view> parts);
 
     void pattern_count(int value);
 
+    /**
+     * @brief PWM frequency in Hz, or -1 if unknown. Only reads the device if the state is not known yet.
+     */
     auto get_pwm_freq() -> int;
 
-    void pattern_matrix(std::vector<bool>& matrix);
+    void pattern_matrix(const MatrixBitmap& matrix);
+
+    /**
+     * @brief Show a 1-bit frame, skipping the transfer if the panel is already showing it.
+     *
+     * Frames have to come from a single thread at a time, see Transport::submit_frame().
+     */
+    void draw(const Frame& frame);
 
-    void pattern_equalizer(std::vector<uint8_t>& values);
+    void pattern_equalizer(std::span<const uint8_t> values);
+
+    /**
+     * @brief Show a greyscale image.
+     *
+     * The device clears its column buffer after every commit, so only columns that are not
+     * entirely dark are staged, followed by a single commit. The panel never shows a partially
+     * updated image.
+     */
+    void draw_grey(const Framebuffer& framebuffer);
 
     void brightness(uint8_t value)
     {
@@ -163,12 +237,10 @@ namespace fw16led::ledmatrix
       this->send_command(Command::Brightness, {value});
     }
 
-    auto get_brightness() -> uint8_t
-    {
-      LOG_TRACE("Getting current global brightness");
-      auto res = this->send_command_with_response(Command::Brightness);
-      return !res.empty() ? res[0] : 0;
-    }
+    /**
+     * @brief Global brightness. Only reads the device if the state is not known yet.
+     */
+    auto get_brightness() -> uint8_t;
 
     void set_sleep(bool sleep = true)
     {
@@ -180,5 +252,55 @@ namespace fw16led::ledmatrix
     {
       this->set_sleep(false);
     }
+
+    /**
+     * @brief The USB device this matrix is connected through, or nullptr if it is simulated.
+     */
+    auto get_device() const -> libusb_device*
+    {
+      return transport->get_device();
+    }
+
+    /**
+     * @brief Whether the device is still reachable. Once disconnected, all commands are dropped.
+     */
+    auto is_connected() const -> bool
+    {
+      return transport->get_state() == LinkState::Connected;
+    }
+
+    /**
+     * @brief Time of the last command that was actually sent to the device.
+     */
+    auto get_last_transfer() const -> std::chrono::steady_clock::time_point
+    {
+      return lastTransfer;
+    }
+
+    /**
+     * @brief When the device last accepted a frame, see Transport::get_last_frame_shown().
+     */
+    auto get_last_frame_shown() const -> std::chrono::steady_clock::time_point
+    {
+      return transport->get_last_frame_shown();
+    }
+
+    auto get_frame_stats() const -> FrameStats
+    {
+      return {framesSent.load(std::memory_order_relaxed), framesElided.load(std::memory_order_relaxed)};
+    }
+
+    auto get_transport_stats() const -> TransportStats
+    {
+      return transport->get_stats();
+    }
+
+    /**
+     * @brief Snapshot of all counters. Can be called from any thread.
+     */
+    auto get_metrics() const -> PanelMetrics
+    {
+      return {get_transport_stats(), get_frame_stats()};
+    }
   };
 } // namespace fw16led::ledmatrix
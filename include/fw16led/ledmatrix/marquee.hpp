@@ -0,0 +1,35 @@
+#pragma once
+
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Text of any length scrolling from the bottom of the matrix to the top.
+   *
+   * The text is rasterised once into a strip with one WIDTH bit mask per row, followed by a
+   * screen of blank rows so the text leaves the matrix before it enters again. Each scroll
+   * step only copies a window of HEIGHT rows out of the strip.
+   */
+  class Marquee
+  {
+  public:
+    explicit Marquee(std::string_view text);
+
+    /**
+     * @brief Number of steps until the text is back where it started.
+     */
+    auto length() const -> int { return static_cast<int>(rows.size()); }
+
+    /**
+     * @brief Render the matrix as it looks after scrolling up by the given number of rows.
+     */
+    void render(int step, Frame& frame) const;
+
+  private:
+    std::vector<uint16_t> rows;
+  };
+} // namespace fw16led::ledmatrix
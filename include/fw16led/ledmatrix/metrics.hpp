@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Histogram of durations with power of two buckets.
+   *
+   * Bucket 0 holds everything below 2 us, bucket i durations from 2^i up to 2^(i + 1) us. The
+   * last bucket also takes everything longer. Recording is a handful of instructions, so it can
+   * happen on every transfer.
+   */
+  class LatencyHistogram
+  {
+  public:
+    static constexpr size_t BUCKETS = 24;
+
+    void record(std::chrono::microseconds latency)
+    {
+      auto us = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+      size_t bucket = us < 2 ? 0 : std::bit_width(us) - 1;
+      buckets[std::min(bucket, BUCKETS - 1)]++;
+      total++;
+    }
+
+    auto count() const -> uint64_t { return total; }
+
+    auto get_buckets() const -> const std::array<uint64_t, BUCKETS>& { return buckets; }
+
+    /**
+     * @brief Exclusive upper limit of a bucket.
+     */
+    static constexpr auto bucket_limit(size_t bucket) -> std::chrono::microseconds
+    {
+      return std::chrono::microseconds(int64_t(1) << (bucket + 1));
+    }
+
+    /**
+     * @brief Upper limit of the bucket containing the given fraction of all durations, 0 if there are none.
+     */
+    auto percentile(double fraction) const -> std::chrono::microseconds
+    {
+      if (total == 0)
+        return std::chrono::microseconds(0);
+
+      auto rank = static_cast<uint64_t>(fraction * total);
+      uint64_t seen = 0;
+      for (size_t i = 0; i < BUCKETS; ++i)
+      {
+        seen += buckets[i];
+        if (seen > rank)
+          return bucket_limit(i);
+      }
+      return bucket_limit(BUCKETS - 1);
+    }
+
+  private:
+    std::array<uint64_t, BUCKETS> buckets{};
+    uint64_t total = 0;
+  };
+} // namespace fw16led::ledmatrix
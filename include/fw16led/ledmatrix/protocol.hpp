@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace fw16led::ledmatrix
+{
+  enum class Command : uint8_t
+  {
+    Brightness = 0x00,
+    Pattern = 0x01,
+    BootloaderReset = 0x02,
+    Sleep = 0x03,
+    Animate = 0x04,
+    Panic = 0x05,
+    Draw = 0x06,
+    StageGreyCol = 0x07,
+    DrawGreyColBuffer = 0x08,
+    SetText = 0x09,
+    StartGame = 0x10,
+    GameControl = 0x11,
+    GameStatus = 0x12,
+    SetColor = 0x13,
+    DisplayOn = 0x14,
+    InvertScreen = 0x15,
+    SetPixelColumn = 0x16,
+    FlushFramebuffer = 0x17,
+    ClearRam = 0x18,
+    ScreenSaver = 0x19,
+    SetFps = 0x1A,
+    SetPowerMode = 0x1B,
+    PwmFreq = 0x1E,
+    DebugMode = 0x1F,
+    Version = 0x20,
+  };
+
+  /**
+   * @brief Number of command codes, for tables indexed by command.
+   */
+  inline constexpr size_t COMMAND_COUNT = static_cast<size_t>(Command::Version) + 1;
+
+  inline auto command_name(Command command) -> const char*
+  {
+    switch (command)
+    {
+    case Command::Brightness:
+      return "brightness";
+    case Command::Pattern:
+      return "pattern";
+    case Command::BootloaderReset:
+      return "bootloader_reset";
+    case Command::Sleep:
+      return "sleep";
+    case Command::Animate:
+      return "animate";
+    case Command::Panic:
+      return "panic";
+    case Command::Draw:
+      return "draw";
+    case Command::StageGreyCol:
+      return "stage_grey_col";
+    case Command::DrawGreyColBuffer:
+      return "draw_grey_col_buffer";
+    case Command::SetText:
+      return "set_text";
+    case Command::StartGame:
+      return "start_game";
+    case Command::GameControl:
+      return "game_control";
+    case Command::GameStatus:
+      return "game_status";
+    case Command::SetColor:
+      return "set_color";
+    case Command::DisplayOn:
+      return "display_on";
+    case Command::InvertScreen:
+      return "invert_screen";
+    case Command::SetPixelColumn:
+      return "set_pixel_column";
+    case Command::FlushFramebuffer:
+      return "flush_framebuffer";
+    case Command::ClearRam:
+      return "clear_ram";
+    case Command::ScreenSaver:
+      return "screen_saver";
+    case Command::SetFps:
+      return "set_fps";
+    case Command::SetPowerMode:
+      return "set_power_mode";
+    case Command::PwmFreq:
+      return "pwm_freq";
+    case Command::DebugMode:
+      return "debug_mode";
+    case Command::Version:
+      return "version";
+    default:
+      return "unknown";
+    }
+  }
+
+  enum class IntegratedPattern : uint8_t
+  {
+    Percentage = 0x00,
+    Gradient = 0x01,
+    DoubleGradient = 0x02,
+    DisplayLotus = 0x03,
+    ZigZag = 0x04,
+    FullBrightness = 0x05,
+    DisplayPanic = 0x06,
+    DisplayLotus2 = 0x07,
+  };
+
+  constexpr unsigned int VID = 0x32AC;
+  constexpr unsigned int PID = 0x0020;
+
+  constexpr int WIDTH = 9;
+  constexpr int HEIGHT = 34;
+  constexpr int PIXELS = WIDTH * HEIGHT;
+  constexpr int FRAME_SIZE = (PIXELS + 7) / 8;
+
+  /**
+   * @brief Parameters of Command::Draw, bit i being the pixel at x + y * WIDTH.
+   */
+  using Frame = std::array<uint8_t, FRAME_SIZE>;
+
+  inline constexpr std::array<uint8_t, 2> FWK_MAGIG = {0x32, 0xAC};
+  inline constexpr uint8_t RESPONSE_SIZE = 32;
+  inline constexpr uint8_t ENDPOINT_OUT = 0x01;
+  inline constexpr uint8_t ENDPOINT_IN = 0x82;
+  inline constexpr int TRANSFER_TIMEOUT_MS = 100;
+
+  /**
+   * @brief Largest packet (magic, command and parameters) the application ever sends.
+   */
+  inline constexpr int MAX_PACKET_SIZE = 64;
+} // namespace fw16led::ledmatrix
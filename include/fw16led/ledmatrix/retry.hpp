@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <libusb.h>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Why a transfer failed, as far as deciding what to do next is concerned.
+   */
+  enum class TransferFailure : uint8_t
+  {
+    Timeout = 0,   /**< The device did not answer in time, worth retrying. */
+    NoDevice = 1,  /**< The device is gone, retrying is pointless. */
+    Pipe = 2,      /**< The endpoint stalled and has to be cleared before retrying. */
+    Overflow = 3,  /**< The device sent more data than expected. */
+    Cancelled = 4, /**< The transfer was cancelled by us. */
+    Other = 5      /**< Any other I/O error. */
+  };
+
+  inline auto classify_failure(libusb_transfer_status status) -> TransferFailure
+  {
+    switch (status)
+    {
+    case LIBUSB_TRANSFER_TIMED_OUT:
+      return TransferFailure::Timeout;
+    case LIBUSB_TRANSFER_NO_DEVICE:
+      return TransferFailure::NoDevice;
+    case LIBUSB_TRANSFER_STALL:
+      return TransferFailure::Pipe;
+    case LIBUSB_TRANSFER_OVERFLOW:
+      return TransferFailure::Overflow;
+    case LIBUSB_TRANSFER_CANCELLED:
+      return TransferFailure::Cancelled;
+    default:
+      return TransferFailure::Other;
+    }
+  }
+
+  inline auto classify_failure(libusb_error error) -> TransferFailure
+  {
+    switch (error)
+    {
+    case LIBUSB_ERROR_TIMEOUT:
+      return TransferFailure::Timeout;
+    case LIBUSB_ERROR_NO_DEVICE:
+      return TransferFailure::NoDevice;
+    case LIBUSB_ERROR_PIPE:
+      return TransferFailure::Pipe;
+    case LIBUSB_ERROR_OVERFLOW:
+      return TransferFailure::Overflow;
+    default:
+      return TransferFailure::Other;
+    }
+  }
+
+  inline auto failure_name(TransferFailure failure) -> const char*
+  {
+    switch (failure)
+    {
+    case TransferFailure::Timeout:
+      return "timeout";
+    case TransferFailure::NoDevice:
+      return "no device";
+    case TransferFailure::Pipe:
+      return "pipe";
+    case TransferFailure::Overflow:
+      return "overflow";
+    case TransferFailure::Cancelled:
+      return "cancelled";
+    default:
+      return "other";
+    }
+  }
+
+  /**
+   * @brief Decides whether and when a failed transfer is attempted again.
+   *
+   * The delay before attempt n (starting at 1 for the first retry) is
+   * initialBackoff * multiplier^(n - 1), capped at maxBackoff. A command is given up once
+   * maxAttempts were made or the next attempt would start after its deadline.
+   */
+  struct RetryPolicy
+  {
+    int maxAttempts = 4;                          /**< Total attempts including the first one. */
+    std::chrono::milliseconds initialBackoff{10}; /**< Delay before the first retry. */
+    std::chrono::milliseconds maxBackoff{250};    /**< Upper bound for a single delay. */
+    double multiplier = 2.0;                      /**< Growth factor between retries. */
+    std::chrono::milliseconds deadline{1000};     /**< Time budget for a command, counted from its first attempt. */
+
+    auto backoff(int retry) const -> std::chrono::milliseconds
+    {
+      double delay = static_cast<double>(initialBackoff.count());
+      for (int i = 1; i < retry && delay < maxBackoff.count(); i++)
+        delay *= multiplier;
+      return std::min(std::chrono::milliseconds(static_cast<int64_t>(delay)), maxBackoff);
+    }
+
+    /**
+     * @brief Whether another attempt should be made after a failure.
+     * @param failure Classification of the failure.
+     * @param attempts Number of attempts made so far.
+     * @param elapsed Time since the first attempt.
+     */
+    auto should_retry(TransferFailure failure, int attempts, std::chrono::steady_clock::duration elapsed) const -> bool
+    {
+      if (failure == TransferFailure::NoDevice || failure == TransferFailure::Cancelled)
+        return false;
+      if (attempts >= maxAttempts)
+        return false;
+      return elapsed + backoff(attempts) <= deadline;
+    }
+  };
+} // namespace fw16led::ledmatrix
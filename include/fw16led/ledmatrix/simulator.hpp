@@ -0,0 +1,130 @@
+#pragma once
+
+#include "fw16led/ledmatrix/framebuffer.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include "fw16led/ledmatrix/transport.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief A frame the simulated panel started showing.
+   */
+  struct SimulatedFrame
+  {
+    std::chrono::steady_clock::time_point time;
+    Framebuffer pixels; /**< 1-bit frames are stored with lit pixels at full brightness. */
+  };
+
+  /**
+   * @brief Faults and delays a SimulatedPanel adds to every transfer.
+   */
+  struct SimulatedFaults
+  {
+    std::chrono::microseconds latency{0}; /**< Time every transfer takes. */
+    std::chrono::microseconds jitter{0};  /**< Up to this much is randomly added to the latency. */
+    double failureRate = 0.0;             /**< Probability of a transfer failing. */
+    TransferFailure failure = TransferFailure::Timeout;
+  };
+
+  /**
+   * @brief In-process model of the LED matrix firmware.
+   *
+   * Decodes the same packets a real panel receives, keeps the state they change, answers
+   * queries and records every frame that is shown. All functions are thread safe, so the
+   * state can be inspected while a SimulatedTransport is driving the panel.
+   */
+  class SimulatedPanel
+  {
+  public:
+    /**
+     * @brief Number of frames kept by get_frames(), older ones are dropped.
+     */
+    static constexpr size_t FRAME_HISTORY = 4096;
+
+    explicit SimulatedPanel(uint32_t seed = 0);
+
+    /**
+     * @brief Process a packet sent to the OUT endpoint.
+     * @return The response the panel puts on the IN endpoint, or std::nullopt if the command has none.
+     */
+    auto receive(std::span<const uint8_t> packet) -> std::optional<std::array<uint8_t, RESPONSE_SIZE>>;
+
+    void set_faults(const SimulatedFaults& faults);
+
+    /**
+     * @brief Make every following transfer fail with TransferFailure::NoDevice.
+     */
+    void unplug();
+
+    /**
+     * @brief Roll the dice for the next transfer.
+     * @return How long the transfer takes and whether it fails.
+     */
+    auto next_transfer() -> std::pair<std::chrono::microseconds, std::optional<TransferFailure>>;
+
+    auto get_frames() const -> std::vector<SimulatedFrame>;
+    void clear_frames();
+
+    auto get_brightness() const -> uint8_t;
+    auto is_sleeping() const -> bool;
+    auto is_animating() const -> bool;
+    auto get_pattern() const -> std::optional<IntegratedPattern>; /**< Pattern being shown, if it is not a frame. */
+    auto get_packets_received() const -> uint64_t;
+    auto get_bytes_received() const -> uint64_t;
+
+  private:
+    void show(const Framebuffer& pixels);
+
+    mutable std::mutex mutex;
+    SimulatedFaults faults;
+    bool plugged = true;
+    std::mt19937 random;
+
+    uint8_t brightness = 51;
+    bool sleeping = false;
+    bool animating = false;
+    uint8_t pwmFreq = 0;
+    std::optional<IntegratedPattern> pattern;
+    Framebuffer columnBuffer;
+    std::deque<SimulatedFrame> frames;
+    uint64_t packetsReceived = 0;
+    uint64_t bytesReceived = 0;
+  };
+
+  /**
+   * @brief Transport delivering packets to a SimulatedPanel instead of a USB device.
+   *
+   * Transfers complete on the TransferEngine thread after the latency configured on the panel,
+   * exactly like asynchronous libusb transfers do, so the queueing, retry and disconnect paths
+   * behave the same as with real hardware.
+   */
+  class SimulatedTransport : public Transport
+  {
+  public:
+    SimulatedTransport(std::shared_ptr<SimulatedPanel> panel, TransferEngine& engine, RetryPolicy retryPolicy = {});
+    ~SimulatedTransport() override;
+
+    auto get_panel() const -> const std::shared_ptr<SimulatedPanel>& { return panel; }
+
+  protected:
+    auto begin_out(std::span<const uint8_t> packet) -> std::optional<TransferFailure> override;
+    auto begin_in(std::span<uint8_t> buffer) -> std::optional<TransferFailure> override;
+    void cancel_transfer() override;
+    void clear_halt(uint8_t endpoint) override;
+
+  private:
+    std::shared_ptr<SimulatedPanel> panel;
+    std::optional<std::array<uint8_t, RESPONSE_SIZE>> response; /**< Answer to the last packet, waiting to be read. */
+    TransferEngine::TaskId task = 0;                            /**< Completion of the transfer in flight. */
+  };
+} // namespace fw16led::ledmatrix
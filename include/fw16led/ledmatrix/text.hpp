@@ -0,0 +1,51 @@
+#pragma once
+
+#include "fw16led/ledmatrix/font.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Number of glyphs that fit on the matrix stacked from top to bottom.
+   */
+  inline constexpr int TEXT_MAX_GLYPHS = 5;
+
+  inline constexpr int TEXT_LEFT = 2;
+  inline constexpr int TEXT_LINE_HEIGHT = 7;
+
+  /**
+   * @brief Glyph rows with the leftmost pixel in the lowest bit, which is the order pixels have in a frame.
+   */
+  inline constexpr auto MIRRORED_ROWS = []()
+  {
+    std::array<uint8_t, 1 << FONT_WIDTH> rows{};
+    for (int row = 0; row < static_cast<int>(rows.size()); ++row)
+    {
+      for (int x = 0; x < FONT_WIDTH; ++x)
+      {
+        if (row & (1 << x))
+          rows[row] |= 1 << (FONT_WIDTH - 1 - x);
+      }
+    }
+    return rows;
+  }();
+
+  /**
+   * @brief Set the pixels of a glyph in a 1-bit frame, with its top left corner at (x, y).
+   */
+  void draw_glyph(Frame& frame, const Glyph& glyph, int x, int y);
+
+  /**
+   * @brief Render the first TEXT_MAX_GLYPHS characters of a UTF-8 string into a frame.
+   */
+  void render_text(std::string_view text, Frame& frame);
+
+  /**
+   * @brief Render the first TEXT_MAX_GLYPHS symbols into a frame, see get_char(std::string_view).
+   */
+  void render_symbols(std::span<const std::string_view> symbols, Frame& frame);
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "fw16led/ledmatrix/engine.hpp"
+#include "fw16led/ledmatrix/metrics.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include "fw16led/ledmatrix/retry.hpp"
+#include "fw16led/ledmatrix/triplebuffer.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <libusb.h>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Connection state of a transport.
+   */
+  enum class LinkState : uint8_t
+  {
+    Connected = 0,   /**< Commands are being sent to the device. */
+    Disconnected = 1 /**< The device is gone, every command fails immediately. */
+  };
+
+  /**
+   * @brief Counters describing the traffic of a transport.
+   */
+  struct TransportStats
+  {
+    uint64_t packetsSent = 0; /**< Packets the device accepted. */
+    uint64_t bytesSent = 0;   /**< Bytes of those packets, including the magic and command byte. */
+    uint64_t retries = 0;     /**< Transfers that were repeated after a failure. */
+    uint64_t timeouts = 0;    /**< Transfers that timed out, whether they were retried or not. */
+    uint64_t failures = 0;    /**< Commands that were given up on. */
+
+    std::array<uint64_t, COMMAND_COUNT> commandsSent{}; /**< Packets the device accepted, by command. */
+    LatencyHistogram latency;                           /**< Time from the first attempt until a command completed. */
+  };
+
+  /**
+   * @brief Asynchronous command queue for a single LED matrix.
+   *
+   * Commands are queued in a bounded ring buffer and sent one at a time, so callers never wait
+   * on the bus. Completions are handled on the TransferEngine thread. Failed transfers are
+   * retried according to a RetryPolicy; once the device reports that it is gone the transport
+   * switches to LinkState::Disconnected.
+   *
+   * Moving the bytes is left to a backend implementing the protected transfer functions, see
+   * LibusbTransport and SimulatedTransport. Backends have to call close() in their destructor.
+   *
+   * Draw frames can also be handed over through submit_frame(), which never takes the queue lock,
+   * so a thread rendering frames is not held up by completions running on the engine thread.
+   */
+  class Transport
+  {
+  public:
+    /**
+     * @brief Callback receiving the response of a command, or an empty vector if it failed.
+     */
+    using ResponseCallback = std::function<void(std::vector<uint8_t>)>;
+
+    /**
+     * @brief A command that is part of a batch, see submit_batch().
+     */
+    struct Request
+    {
+      Command command;
+      std::span<const uint8_t> parameters;
+      ResponseCallback onResponse = nullptr; /**< If set, the response is read before the next command is sent. */
+      std::function<void()> onFailure = nullptr; /**< Called on the event thread if the command could not be sent. */
+    };
+
+    static constexpr size_t QUEUE_CAPACITY = 16;
+
+    Transport(TransferEngine& engine, RetryPolicy retryPolicy = {});
+    virtual ~Transport() = default;
+
+    Transport(const Transport&) = delete;
+    Transport& operator=(const Transport&) = delete;
+
+    /**
+     * @brief Queue a command that does not expect a response.
+     */
+    void submit(Command command, std::span<const uint8_t> parameters);
+
+    /**
+     * @brief Queue a command and read its response once it was sent.
+     * @param onResponse Called on the event thread with the response.
+     */
+    void submit(Command command, std::span<const uint8_t> parameters, ResponseCallback onResponse);
+
+    /**
+     * @brief Queue a command and read its response once it was sent.
+     * @return Future resolving to the response, or an empty vector if the command failed.
+     */
+    auto submit_with_response(Command command, std::span<const uint8_t> parameters) -> std::future<std::vector<uint8_t>>;
+
+    /**
+     * @brief Queue several commands that must reach the device back to back.
+     *
+     * Either all commands are queued or, if there is not enough room left, none of them. Queries
+     * in a batch are answered in order without other commands getting in between, so several of
+     * them cost one wait instead of one per query.
+     * @return Whether the commands were queued. If not, no response callback is called.
+     */
+    auto submit_batch(std::span<const Request> requests) -> bool;
+
+    /**
+     * @brief Hand a Draw frame over without taking the queue lock.
+     *
+     * Only one thread may submit frames at a time. The frame is queued on the engine thread or
+     * in front of the next command that is submitted, whichever happens first. Until then it is
+     * replaced by any newer frame.
+     */
+    void submit_frame(const Frame& frame);
+
+    /**
+     * @brief Drop all queued commands and cancel the one in flight.
+     *
+     * Blocks until the device no longer references any buffer owned by this transport.
+     */
+    void close();
+
+    auto get_state() const -> LinkState { return state; }
+
+    auto get_stats() -> TransportStats;
+
+    /**
+     * @brief When the device last accepted a command that changes what it shows, i.e. Draw or DrawGreyColBuffer.
+     */
+    auto get_last_frame_shown() const -> std::chrono::steady_clock::time_point
+    {
+      return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(lastFrameShown.load(std::memory_order_relaxed)));
+    }
+
+    /**
+     * @brief The USB device behind this transport, or nullptr if there is none.
+     */
+    virtual auto get_device() const -> libusb_device* { return nullptr; }
+
+  protected:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Start sending a packet to the device. Called with the queue locked.
+     * @return The failure if the transfer could not be started.
+     */
+    virtual auto begin_out(std::span<const uint8_t> packet) -> std::optional<TransferFailure> = 0;
+
+    /**
+     * @brief Start reading a response into the buffer. Called with the queue locked.
+     * @return The failure if the transfer could not be started.
+     */
+    virtual auto begin_in(std::span<uint8_t> buffer) -> std::optional<TransferFailure> = 0;
+
+    /**
+     * @brief Cancel the transfer in flight, which still has to complete with TransferFailure::Cancelled.
+     * Called with the queue locked.
+     */
+    virtual void cancel_transfer() = 0;
+
+    /**
+     * @brief Clear a stalled endpoint before a retry. Called without holding the lock.
+     */
+    virtual void clear_halt(uint8_t endpoint) = 0;
+
+    /**
+     * @brief Report that the transfer started last finished. Must be called on the engine thread.
+     * @param length Number of bytes actually transferred.
+     */
+    void transfer_done(std::optional<TransferFailure> failure, int length);
+
+    /**
+     * @brief Whether no transfer or retry is outstanding, i.e. the backend's buffers are unused.
+     */
+    auto is_idle() -> bool;
+
+    TransferEngine& engine;
+
+  private:
+
+    struct Packet
+    {
+      Command command;
+      std::array<uint8_t, MAX_PACKET_SIZE> data;
+      uint8_t length = 0;
+      uint8_t attempts = 0;
+      Clock::time_point firstAttempt;
+      ResponseCallback onResponse;
+      std::function<void()> onFailure;
+    };
+
+    enum class Stage : uint8_t
+    {
+      Out,
+      In,
+      Backoff
+    };
+
+    /**
+     * @brief Callbacks collected while holding the lock, invoked once it was released.
+     */
+    using Completions = std::vector<std::pair<ResponseCallback, std::vector<uint8_t>>>;
+
+    static void fill_packet(Packet& packet, Command command, std::span<const uint8_t> parameters);
+
+    auto enqueue(Command command, std::span<const uint8_t> parameters, ResponseCallback& onResponse) -> bool;
+    void take_frame();
+    void pump_frame();
+    void retry();
+    void start_next(Completions& done);
+    void handle_failure(TransferFailure failure, Completions& done);
+    void finish(bool ok, std::vector<uint8_t> response, Completions& done);
+    static void fail(Packet& packet, Completions& done);
+    void disconnect(Completions& done);
+    auto pop_front() -> Packet;
+
+    const RetryPolicy retryPolicy;
+    std::array<uint8_t, RESPONSE_SIZE> responseBuffer{};
+    std::atomic<LinkState> state = LinkState::Connected;
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::array<Packet, QUEUE_CAPACITY> queue; /**< Ring buffer, the head is the packet being processed. */
+    size_t head = 0;
+    size_t count = 0;
+    bool busy = false; /**< Whether the head packet is in flight or waiting for a retry. */
+    bool closing = false;
+    Stage stage = Stage::Out;
+    TransferEngine::TaskId retryTask = 0;
+    uint8_t haltedEndpoint = 0; /**< Endpoint to clear before the next retry, 0 if none. */
+    TransportStats stats;
+    std::atomic<Clock::rep> lastFrameShown = 0; /**< See get_last_frame_shown(), atomic so that it can be read without the lock. */
+
+    TripleBuffer<Frame> frames;                       /**< Frames from submit_frame(), taken with the queue locked. */
+    std::atomic<bool> framePending = false;           /**< Whether a pump_frame() task is scheduled. */
+    std::atomic<TransferEngine::TaskId> pumpTask = 0; /**< The scheduled pump_frame() task. */
+  };
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Lock-free handoff of the latest value from one producer thread to one consumer thread.
+   *
+   * The producer fills the back buffer and publishes it by swapping it with the middle buffer,
+   * the consumer swaps the middle buffer with its front buffer whenever something new was
+   * published. Neither side ever waits for the other. Values published faster than they are
+   * taken replace each other, so the consumer always gets the most recent one.
+   *
+   * Each side may be driven by different threads over time, as long as calls on the same side
+   * are serialized, e.g. by a mutex.
+   */
+  template <typename T>
+  class TripleBuffer
+  {
+  public:
+    /**
+     * @brief Buffer to fill before calling publish(). Producer only.
+     */
+    auto back() -> T& { return buffers[backIndex]; }
+
+    /**
+     * @brief Hand the back buffer over to the consumer. Producer only.
+     */
+    void publish()
+    {
+      backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /**
+     * @brief Move the most recently published value to the front buffer. Consumer only.
+     * @return Whether there was a new value.
+     */
+    auto take() -> bool
+    {
+      // Only the consumer clears the flag, so it cannot disappear before the exchange
+      if (!(middle.load(std::memory_order_relaxed) & FRESH))
+        return false;
+      frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+      return true;
+    }
+
+    /**
+     * @brief The value taken last. Consumer only.
+     */
+    auto front() const -> const T& { return buffers[frontIndex]; }
+
+  private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH = 0x04; /**< Set in middle while it holds a value the consumer has not taken. */
+
+    std::array<T, 3> buffers{};
+    std::atomic<uint8_t> middle = 1;
+    uint8_t frontIndex = 0;
+    uint8_t backIndex = 2;
+  };
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "fw16led/ledmatrix/transport.hpp"
+#include <libusb.h>
+#include <memory>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Transport talking to a real LED matrix through libusb's asynchronous API.
+   *
+   * Takes ownership of an opened device handle whose interface 1 has been claimed, and hands
+   * the device back to the kernel driver when destroyed.
+   */
+  class LibusbTransport : public Transport
+  {
+  public:
+    LibusbTransport(libusb_device_handle* device, TransferEngine& engine, RetryPolicy retryPolicy = {});
+    ~LibusbTransport() override;
+
+    auto get_device() const -> libusb_device* override
+    {
+      return libusb_get_device(device.get());
+    }
+
+  protected:
+    auto begin_out(std::span<const uint8_t> packet) -> std::optional<TransferFailure> override;
+    auto begin_in(std::span<uint8_t> buffer) -> std::optional<TransferFailure> override;
+    void cancel_transfer() override;
+    void clear_halt(uint8_t endpoint) override;
+
+  private:
+    static void LIBUSB_CALL on_transfer_done(libusb_transfer* transfer);
+
+    auto submit_transfer() -> std::optional<TransferFailure>;
+
+    std::unique_ptr<libusb_device_handle, decltype(&libusb_close)> device;
+    libusb_transfer* transfer;
+  };
+} // namespace fw16led::ledmatrix
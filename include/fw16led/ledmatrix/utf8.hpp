@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace fw16led::ledmatrix
+{
+  inline constexpr char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+  /**
+   * @brief Decode the next code point and remove it from the front of the input.
+   *
+   * Malformed sequences consume a single byte and yield REPLACEMENT_CHARACTER, so decoding
+   * always makes progress.
+   */
+  constexpr auto next_code_point(std::string_view& text) -> char32_t
+  {
+    auto byte = [&](size_t i)
+    { return static_cast<uint8_t>(text[i]); };
+
+    uint8_t lead = byte(0);
+    if (lead < 0x80)
+    {
+      text.remove_prefix(1);
+      return lead;
+    }
+
+    size_t length;
+    char32_t codePoint;
+    char32_t minimum;
+    if ((lead & 0xE0) == 0xC0)
+    {
+      length = 2;
+      codePoint = lead & 0x1F;
+      minimum = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+      length = 3;
+      codePoint = lead & 0x0F;
+      minimum = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+      length = 4;
+      codePoint = lead & 0x07;
+      minimum = 0x10000;
+    }
+    else
+    {
+      text.remove_prefix(1);
+      return REPLACEMENT_CHARACTER;
+    }
+
+    if (text.size() < length)
+    {
+      text.remove_prefix(1);
+      return REPLACEMENT_CHARACTER;
+    }
+
+    for (size_t i = 1; i < length; ++i)
+    {
+      if ((byte(i) & 0xC0) != 0x80)
+      {
+        text.remove_prefix(1);
+        return REPLACEMENT_CHARACTER;
+      }
+      codePoint = (codePoint << 6) | (byte(i) & 0x3F);
+    }
+
+    // Reject overlong encodings, surrogates and values beyond the Unicode range
+    if (codePoint < minimum || (codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF)
+    {
+      text.remove_prefix(1);
+      return REPLACEMENT_CHARACTER;
+    }
+
+    text.remove_prefix(length);
+    return codePoint;
+  }
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Splits audio into one log-spaced frequency band per matrix column.
+   *
+   * A Hann window of WINDOW samples goes through a real FFT, computed as a complex FFT of half
+   * the size. Real and imaginary parts are kept in separate arrays and every butterfly stage runs
+   * over contiguous ranges, so release builds (-O3) vectorise the butterflies without intrinsics. All
+   * tables are computed up front, analyse() does not allocate.
+   */
+  class Spectrum
+  {
+  public:
+    static constexpr size_t WINDOW = 1024;
+    static constexpr size_t BANDS = ledmatrix::WIDTH;
+    static constexpr float MIN_FREQUENCY = 40.0f;
+    static constexpr float MAX_FREQUENCY = 16000.0f;
+    static constexpr float RANGE_DB = 60.0f; /**< Levels below full scale that are still shown. */
+
+    using Levels = std::array<float, BANDS>;
+
+    explicit Spectrum(int sampleRate);
+
+    /**
+     * @brief Level of each band, from 0 at RANGE_DB below full scale to 1 for a full scale sine.
+     * @param samples The most recent WINDOW samples, from -1 to 1, oldest first.
+     */
+    void analyse(std::span<const float, WINDOW> samples, Levels& levels);
+
+  private:
+    static constexpr size_t HALF = WINDOW / 2;
+
+    void transform();
+
+    std::vector<float> window;
+    std::vector<uint32_t> reversed;                         /**< Bit reversed position of each complex input. */
+    std::vector<float> twiddleRe, twiddleIm;                /**< Twiddles of all stages, one stage after the other. */
+    std::vector<float> unpackRe, unpackIm;                  /**< Twiddles turning the half size FFT into the real one. */
+    std::array<std::pair<size_t, size_t>, BANDS> binRanges; /**< First and past the last FFT bin of each band. */
+    std::vector<float> re, im;
+  };
+
+  /**
+   * @brief Reads PCM from a file or named pipe and publishes its spectrum, Linux only.
+   *
+   * Samples are signed 16-bit little endian mono at the given rate, as written by e.g.
+   * `parec --format=s16le --channels=1`. Named pipes are reopened when the writer goes away,
+   * regular files are played in a loop at the sample rate, which is handy for testing.
+   *
+   * Analysis runs on its own thread every HOP_RATE-th of a second. Whatever the pipe holds is
+   * drained first and only the newest window is analysed, so levels never lag behind the
+   * audio by more than a window and a hop, no matter how late the reader was.
+   *
+   * A pipe can only be read once, so all presets showing the same source share one capture.
+   */
+  class AudioCapture
+  {
+  public:
+    static constexpr int HOP_RATE = 60;
+
+    /**
+     * @brief Levels published by the capture thread.
+     */
+    struct Analysis
+    {
+      Spectrum::Levels levels{};
+      std::chrono::steady_clock::time_point time; /**< When the newest analysed sample was read. */
+      uint64_t sequence = 0;                      /**< Number of analyses so far, 0 if there is none yet. */
+    };
+
+    /**
+     * @brief The capture of a source, started by the first caller and stopped when the last one lets go.
+     */
+    static auto share(const std::string& path, int sampleRate) -> std::shared_ptr<AudioCapture>;
+
+    AudioCapture(std::string path, int sampleRate);
+    ~AudioCapture();
+
+    AudioCapture(const AudioCapture&) = delete;
+    AudioCapture& operator=(const AudioCapture&) = delete;
+
+    auto get_analysis() -> Analysis;
+
+  private:
+    void run();
+    auto open_source() -> bool;
+    void close_source();
+
+    /**
+     * @brief Read what the source holds into the sample history.
+     * @return Number of samples read, or -1 if the source has to be reopened.
+     */
+    auto read_source() -> long;
+
+    /**
+     * @brief Add little endian samples to the history, a trailing odd byte is ignored.
+     */
+    void append(std::span<const uint8_t> pcm);
+
+    std::string path;
+    int sampleRate;
+    size_t hop;
+
+    // Only touched by the capture thread
+    int fd = -1;
+    bool regularFile = false;
+    Spectrum spectrum;
+    std::vector<float> history; /**< Ring of the last WINDOW samples. */
+    size_t historyEnd = 0;
+    std::vector<float> windowed; /**< history, oldest first, ready for analysis. */
+    std::vector<uint8_t> buffer;
+    size_t buffered = 0; /**< Bytes of an incomplete sample left in buffer. */
+
+    std::mutex mutex;
+    Analysis analysis;
+    std::atomic<bool> stopping = false;
+    std::thread thread;
+  };
+} // namespace fw16led::managers
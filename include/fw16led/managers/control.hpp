@@ -0,0 +1,88 @@
+#pragma once
+
+#include "fw16led/PresetOption.hpp"
+#include "fw16led/ledmatrix/canvas.hpp"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QString>
+#include <QStringList>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Message types of the control protocol.
+   *
+   * Every message is a four byte header followed by its payload. The header holds the type, the
+   * id of the panel the message is meant for (ALL_PANELS for every panel) and the length of the
+   * payload as a little endian uint16.
+   */
+  enum class ControlMessage : uint8_t
+  {
+    Frame = 0x01,      /**< FRAME_SIZE bytes in the layout of Command::Draw. */
+    GreyFrame = 0x02,  /**< PIXELS brightness values, column by column from the top left. */
+    Preset = 0x03,     /**< UTF-8 preset id, optionally followed by "\nkey=value" lines setting its options. */
+    Release = 0x04,    /**< Go back to the preset configured in the settings, for ALL_PANELS also stop showing canvases. Empty payload. */
+    Brightness = 0x05, /**< One byte. */
+    ListPanels = 0x06, /**< Empty payload, answered with a ListPanels message holding one byte per panel id. */
+    SharedFrames = 0x07, /**< Empty payload, answered with a SharedFrames message holding the shm_open() name of the panel's SharedFrameLayout. Linux only. */
+    Canvas = 0x08,       /**< PIXELS brightness values per panel, for a canvas spanning all panels ordered by id. The panel id is ignored. */
+    Error = 0x7F,      /**< Sent back for a message that could not be handled, the payload describes why in UTF-8. */
+  };
+
+  inline constexpr size_t CONTROL_HEADER_SIZE = 4;
+
+  /**
+   * @brief Socket name used when none is given. Relative names are created in the temporary directory.
+   */
+  inline constexpr auto DEFAULT_CONTROL_SOCKET = "fw16led";
+
+  /**
+   * @brief Parse "key=value" lines setting a preset's options according to the options it has.
+   * @return The option values, or std::nullopt if a line names an unknown option.
+   */
+  auto parseOptions(const std::string& presetId, const QStringList& lines) -> std::optional<std::unordered_map<std::string, PresetOptionValue>>;
+
+  /**
+   * @brief Local socket server letting other processes drive the panels.
+   *
+   * Lets scripts stream frames or switch presets without going through the settings. Messages
+   * are handled on the Qt main thread, which only hands frames over to the panels; sending
+   * them is left to the render thread. Nothing is answered unless asked for or a message was
+   * rejected, so producers can stream without ever reading from the socket.
+   */
+  class ControlServer
+  {
+  public:
+    ControlServer();
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    /**
+     * @brief Start accepting connections, replacing a stale socket left behind by a previous run.
+     * @return Whether the server is listening.
+     */
+    auto listen(const QString& name) -> bool;
+
+  private:
+    void accept();
+    void receive(QLocalSocket* socket);
+    void handle(QLocalSocket* socket, ControlMessage type, uint8_t panelId, QByteArrayView payload);
+
+    static void send(QLocalSocket* socket, ControlMessage type, uint8_t panelId, QByteArrayView payload);
+    static void reject(QLocalSocket* socket, uint8_t panelId, const QString& reason);
+
+    QLocalServer server;
+    ledmatrix::Canvas canvas;       /**< Reused for Canvas messages, so streaming does not allocate. */
+    std::string sharedFramesPrefix; /**< Derived from the socket name, so that several daemons do not share rings. */
+    std::unordered_map<QLocalSocket*, QByteArray> buffers; /**< Bytes of incomplete messages, by connection. */
+  };
+} // namespace fw16led::managers
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <libusb.h>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Persistent mapping from a panel's physical location to its id.
+   *
+   * The id is what all per-panel settings are keyed by, so it must not depend on the order in
+   * which devices are enumerated. Locations are derived from the USB topology (bus and port
+   * path), which is fixed for the two input module slots of a Framework 16. The mapping is kept
+   * in the settings and mirrored in memory, so looking up an id never touches the disk.
+   */
+  class PanelIdentityStore
+  {
+  public:
+    PanelIdentityStore();
+
+    /**
+     * @brief Get the id for a location, assigning and persisting a new one if it was never seen.
+     *
+     * Ids range from 1 to ALL_PANELS - 1. Once all of them are taken, the lowest id of a location
+     * that is not attached right now is handed over to the new location.
+     * @param attached Ids of the panels that are currently connected.
+     * @return The id, or std::nullopt if every id belongs to an attached panel.
+     */
+    auto idFor(const std::string& location, std::span<const uint8_t> attached) -> std::optional<uint8_t>;
+
+    /**
+     * @brief Whether a panel was ever assigned this id.
+     */
+    auto isKnown(uint8_t id) const -> bool;
+
+    /**
+     * @brief Describe where a device is plugged in, e.g. "3-1.4".
+     *
+     * Falls back to the serial number if the port path is not available on this platform.
+     */
+    static auto locationOf(libusb_device* device, libusb_device_handle* handle) -> std::string;
+
+  private:
+    std::unordered_map<std::string, uint8_t> ids; /**< Known locations and their ids. */
+  };
+} // namespace fw16led::managers
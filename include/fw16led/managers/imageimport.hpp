@@ -0,0 +1,31 @@
+#pragma once
+
+#include "fw16led/ledmatrix/animation.hpp"
+#include <QString>
+#include <atomic>
+#include <optional>
+
+namespace fw16led::managers
+{
+  struct ImageImportOptions
+  {
+    ledmatrix::AnimationFormat format = ledmatrix::AnimationFormat::Grey;
+    bool dither = true; /**< Floyd-Steinberg error diffusion for 1-bit frames instead of a plain threshold. */
+    double gamma = 2.2; /**< Exponent turning image values into light, which is what the panel's brightness is. */
+  };
+
+  /**
+   * @brief Convert an image or animation into an animation file in the cache, unless it is there already.
+   *
+   * Anything QImageReader reads is supported, animated GIFs included. Frames are decoded at a
+   * small multiple of the panel size, averaged down to 9x34 in linear light and added to the
+   * animation one at a time, so even long GIFs are never held in memory as a whole. The cache
+   * is keyed by a hash of the content and the options, so importing the same image again only
+   * costs reading it once for the hash.
+   *
+   * Conversion can take seconds for long animations and is safe to run on any thread.
+   * @param cancelled Checked between frames, conversion stops once it is set.
+   * @return Path of the animation file, or std::nullopt if the image could not be converted.
+   */
+  auto importImage(const QString& path, const ImageImportOptions& options, const std::atomic<bool>& cancelled) -> std::optional<QString>;
+} // namespace fw16led::managers
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "fw16led/LedPanel.hpp"
+#include "fw16led/managers/span.hpp"
+#include <QJsonObject>
+#include <QString>
+#include <memory>
+#include <vector>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Metrics of a single panel as a JSON object.
+   */
+  auto panelMetricsToJson(const LedPanel& panel) -> QJsonObject;
+
+  /**
+   * @brief Commits and skew of the PanelSpan as a JSON object.
+   */
+  auto spanStatsToJson(const SpanStats& stats) -> QJsonObject;
+
+  /**
+   * @brief Metrics of all panels as a JSON object, with one entry per panel under "panels" and the span's under "span".
+   */
+  auto metricsToJson(const std::vector<std::shared_ptr<LedPanel>>& panels, const SpanStats& span) -> QJsonObject;
+
+  /**
+   * @brief Write the metrics of all panels to a file, replacing it atomically so readers never see a partial dump.
+   * @return Whether the file was written.
+   */
+  auto writeMetrics(const QString& path, const std::vector<std::shared_ptr<LedPanel>>& panels, const SpanStats& span) -> bool;
+} // namespace fw16led::managers
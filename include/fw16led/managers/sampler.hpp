@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief System load at one point in time, as published by the SystemSampler.
+   *
+   * Rates are averaged over the time since the previous sample. Values the system does not
+   * provide stay unset.
+   */
+  struct SystemSnapshot
+  {
+    std::chrono::steady_clock::time_point time;
+    uint64_t sequence = 0; /**< Number of samples taken, 0 if there is no snapshot yet. */
+
+    std::optional<double> cpu;             /**< Busy fraction of all cores, from 0 to 1. */
+    std::optional<double> memory;          /**< Fraction of memory that is not available, from 0 to 1. */
+    std::optional<double> networkReceive;  /**< Bytes per second over all interfaces but loopback. */
+    std::optional<double> networkTransmit; /**< Bytes per second over all interfaces but loopback. */
+    std::optional<double> diskRead;        /**< Bytes per second over all whole disks. */
+    std::optional<double> diskWrite;       /**< Bytes per second over all whole disks. */
+    std::optional<double> temperature;     /**< Degrees Celsius of the first CPU sensor found. */
+    std::optional<double> battery;         /**< Charge of the first battery found, from 0 to 1. */
+  };
+
+  /**
+   * @brief Samples system load in the background for any number of presets, Linux only.
+   *
+   * All files are opened and the sensors looked up by the first sample, then read with pread() into
+   * buffers allocated up front and parsed in place, so later samples neither open files nor allocate. A sample costs a few dozen
+   * microseconds and is only taken while at least one subscriber exists, once per SAMPLE_INTERVAL,
+   * no matter how many presets read the snapshots.
+   */
+  class SystemSampler
+  {
+  public:
+    static constexpr auto SAMPLE_INTERVAL = std::chrono::seconds(1);
+
+    SystemSampler();
+    ~SystemSampler();
+
+    SystemSampler(const SystemSampler&) = delete;
+    SystemSampler& operator=(const SystemSampler&) = delete;
+
+    /**
+     * @brief Start sampling if this is the first subscriber. Every call needs a matching unsubscribe().
+     *
+     * The first snapshot after sampling started has no CPU, network and disk rates yet.
+     */
+    void subscribe();
+    void unsubscribe();
+
+    /**
+     * @brief The most recent snapshot, with a sequence of 0 if none was taken yet.
+     */
+    auto get_snapshot() -> SystemSnapshot;
+
+    /**
+     * @brief Take a sample right away on the calling thread. Used by the sampling thread and for benchmarks.
+     */
+    void sample();
+
+  private:
+    /**
+     * @brief A file that is kept open and re-read from the start for every sample.
+     */
+    struct Source
+    {
+      int fd = -1;
+      std::vector<char> buffer; /**< Allocated once, large enough for the whole file. */
+
+      /**
+       * @brief Read the file into the buffer, empty if it could not be read.
+       */
+      auto read() -> std::string_view;
+    };
+
+    /**
+     * @brief Cumulative counters of the previous sample, rates are computed from the difference.
+     */
+    struct Counters
+    {
+      std::chrono::steady_clock::time_point time;
+      uint64_t cpuBusy = 0;
+      uint64_t cpuTotal = 0;
+      uint64_t networkReceive = 0;
+      uint64_t networkTransmit = 0;
+      uint64_t diskRead = 0;
+      uint64_t diskWrite = 0;
+      bool valid = false;
+    };
+
+    static auto open(const char* path, size_t size) -> Source;
+    void discover();
+    void run();
+
+    Source stat;
+    Source meminfo;
+    Source netdev;
+    Source diskstats;
+    Source temperature;
+    Source battery;
+    Counters previous;
+    bool discovered = false; /**< Whether the sources were opened, only touched by whoever calls sample(). */
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    SystemSnapshot snapshot;
+    int subscribers = 0;
+    bool stopping = false;
+    std::thread thread; /**< Started by the first subscribe(), waits without sampling while nobody is subscribed. */
+  };
+} // namespace fw16led::managers
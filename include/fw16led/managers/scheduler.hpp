@@ -0,0 +1,72 @@
+#pragma once
+
+#include "fw16led/LedPanel.hpp"
+#include "fw16led/managers/span.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Drives rendering and keep-alive traffic of all panels from a dedicated render thread.
+   *
+   * Every tick handles all panels in one pass: presets that are due render their next frame and
+   * panels that did not talk to their device for a while are kept awake. Keep-alives that are due
+   * soon are sent together with the ones that are due now, so several panels wake the bus at the
+   * same time instead of one after another. The thread sleeps until the earliest next deadline
+   * and indefinitely when nothing is due.
+   *
+   * Frames are handed to the transports without taking their locks, so neither the GUI thread
+   * nor the USB event thread ever waits for a preset to render.
+   *
+   * The PanelSpan is ticked first, so a canvas it commits reaches all panels within one tick.
+   */
+  class FrameScheduler
+  {
+  public:
+    FrameScheduler();
+    ~FrameScheduler();
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    /**
+     * @brief Start ticking a panel.
+     */
+    void add(std::shared_ptr<LedPanel> panel);
+
+    /**
+     * @brief Stop ticking a panel. Blocks until a tick that is handling it right now finished.
+     */
+    void remove(const std::shared_ptr<LedPanel>& panel);
+
+    /**
+     * @brief Run a tick as soon as possible, e.g. after a panel was added or reconfigured.
+     */
+    void wake();
+
+    /**
+     * @brief The span showing a canvas across all panels. Call wake() after changing it.
+     */
+    auto get_span() -> PanelSpan& { return span; }
+
+  private:
+    void run();
+    auto tick() -> std::optional<Preset::TimePoint>;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable tickDone;
+    std::vector<std::shared_ptr<LedPanel>> panels;
+    std::vector<std::shared_ptr<LedPanel>> ticking; /**< Panels of the tick in progress, empty between ticks. */
+    bool woken = false;
+    bool running = true;
+    PanelSpan span;
+
+    std::thread thread;
+  };
+} // namespace fw16led::managers
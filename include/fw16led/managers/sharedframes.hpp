@@ -0,0 +1,104 @@
+#pragma once
+
+#include "fw16led/ledmatrix/framebuffer.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief One frame in a SharedFrameLayout.
+   */
+  struct SharedFrameSlot
+  {
+    std::atomic<uint32_t> sequence;                  /**< 2n + 1 while frame n is being written, 2n + 2 once it is complete. */
+    uint8_t grey;                                    /**< Whether pixels holds the frame instead of bits. */
+    std::array<uint8_t, ledmatrix::FRAME_SIZE> bits; /**< 1-bit frame in the layout of Command::Draw. */
+    std::array<uint8_t, ledmatrix::PIXELS> pixels;   /**< Greyscale frame, column by column from the top left. */
+  };
+
+  /**
+   * @brief Memory shared with a producer process, holding a ring of frames for one panel.
+   *
+   * To publish frame n (starting at 0, so n is the current value of published), a producer
+   * 1. stores 2n + 1 into the sequence of ring[n % SLOTS],
+   * 2. fills grey and either bits or pixels,
+   * 3. stores 2n + 2 into the sequence,
+   * 4. stores n + 1 into published and wakes published with FUTEX_WAKE.
+   *
+   * The panel always shows the newest frame and skips older ones it did not get to. The
+   * sequence lets it detect a slot that was overwritten while it was reading it.
+   */
+  struct SharedFrameLayout
+  {
+    static constexpr uint32_t MAGIC = 0x36315746; /**< "FW16" in little endian. */
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t SLOTS = 4;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+
+    alignas(64) std::atomic<uint32_t> published; /**< Number of frames published so far, also the futex word. */
+    alignas(64) std::array<SharedFrameSlot, SLOTS> ring;
+  };
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free, "Atomics in shared memory must not need a lock");
+
+  /**
+   * @brief Shared memory ring of frames that a producer process writes to directly, Linux only.
+   *
+   * A thread waits on the futex in the mapping and calls a callback whenever a frame was
+   * published, which only wakes the render thread. The render thread then takes the newest
+   * frame straight from the mapping, without any socket or parsing in between.
+   */
+  class SharedFrameRing
+  {
+  public:
+    /**
+     * @brief Create the shared memory object, replacing a stale one of the same name.
+     * @param name Name for shm_open(), starting with a slash.
+     * @param onFrame Called on the waiting thread whenever a frame was published.
+     * @return The ring, or nullptr if it could not be created or the platform does not support it.
+     */
+    static auto create(const std::string& name, std::function<void()> onFrame) -> std::unique_ptr<SharedFrameRing>;
+
+    ~SharedFrameRing();
+
+    SharedFrameRing(const SharedFrameRing&) = delete;
+    SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+
+    auto get_name() const -> const std::string& { return name; }
+
+    /**
+     * @brief Number of frames published so far.
+     */
+    auto get_published() const -> uint32_t;
+
+    /**
+     * @brief Copy the newest frame if one was published after the given count.
+     * @param seen Frames published when this was called last, updated to the current count.
+     * @return Whether a complete frame was copied.
+     */
+    auto take_latest(uint32_t& seen, bool& grey, ledmatrix::Frame& bits, ledmatrix::Framebuffer& pixels) -> bool;
+
+  private:
+    SharedFrameRing(std::string name, SharedFrameLayout* layout, std::function<void()> onFrame);
+
+    void run();
+
+    std::string name;
+    SharedFrameLayout* layout;
+    std::function<void()> onFrame;
+    std::atomic<bool> running = true;
+    std::atomic<bool> stopped = false; /**< Set by the thread once it no longer waits on the futex. */
+    std::thread thread;
+  };
+} // namespace fw16led::managers
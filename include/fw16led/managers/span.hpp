@@ -0,0 +1,100 @@
+#pragma once
+
+#include "fw16led/CanvasPreset.hpp"
+#include "fw16led/LedPanel.hpp"
+#include "fw16led/ledmatrix/canvas.hpp"
+#include "fw16led/ledmatrix/framebuffer.hpp"
+#include "fw16led/ledmatrix/metrics.hpp"
+#include "fw16led/ledmatrix/triplebuffer.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Counters describing how well the panels of a span stay in lockstep.
+   */
+  struct SpanStats
+  {
+    uint64_t commits = 0;             /**< Canvases split and sent to the panels. */
+    ledmatrix::LatencyHistogram skew; /**< Time between the first and the last panel accepting the same canvas. */
+  };
+
+  /**
+   * @brief Shows a Canvas across all panels, ordered from left to right by ascending id.
+   *
+   * The canvas comes either from a CanvasPreset or from an external producer. Each canvas is split
+   * and handed to all panels from the same scheduler tick, back to back, which suspends their own
+   * presets until the span is stopped. How far apart the panels actually accepted a canvas is
+   * measured from the completion times of the transfers and collected in SpanStats.
+   *
+   * start(), show() and stop() are called on the Qt main thread, tick() on the render thread.
+   */
+  class PanelSpan
+  {
+  public:
+    /**
+     * @brief Render a preset across the panels, replacing what the span showed before.
+     */
+    void start(std::unique_ptr<CanvasPreset> preset);
+
+    /**
+     * @brief Show a canvas across the panels, replacing the preset the span was rendering.
+     *
+     * Canvases that do not have one part per panel are ignored. Must only be called by one
+     * thread at a time.
+     */
+    void show(const ledmatrix::Canvas& canvas);
+
+    /**
+     * @brief Stop showing anything. The panels keep the last canvas until they are reconfigured,
+     * configurations applied while the span was active are installed right away.
+     */
+    void stop();
+
+    auto get_stats() -> SpanStats;
+
+    /**
+     * @brief Render and commit a canvas if one is due.
+     * @param panels All panels being ticked, the span picks them up in the order of their ids.
+     * @return When the span needs to be ticked again, or std::nullopt if it can sleep.
+     */
+    auto tick(Preset::TimePoint now, std::span<const std::shared_ptr<LedPanel>> panels) -> std::optional<Preset::TimePoint>;
+
+  private:
+    /**
+     * @brief Change requested by start(), show() or stop(), waiting to be applied by tick().
+     */
+    struct PendingChange
+    {
+      std::unique_ptr<CanvasPreset> preset; /**< Nothing when streaming or stopping. */
+      bool active = false;
+    };
+
+    void commit();
+    void measureSkew(std::span<const std::shared_ptr<LedPanel>> panels);
+
+    std::mutex mutex;
+    std::optional<PendingChange> pending;
+    SpanStats stats;
+
+    ledmatrix::TripleBuffer<ledmatrix::Canvas> streamed;
+    bool showing = false; /**< Whether show() requested streaming already, only touched by its caller. */
+
+    // Only touched by the render thread
+    bool active = false;
+    std::unique_ptr<CanvasPreset> preset;
+    std::optional<Preset::TimePoint> nextFrame;
+    ledmatrix::Canvas canvas{0};
+    ledmatrix::Framebuffer part;
+    std::vector<LedPanel*> members; /**< Panels of the tick in progress, by ascending id. */
+
+    std::vector<uint8_t> measured; /**< Ids of the panels the last canvas was sent to, until their skew was measured. */
+    std::chrono::steady_clock::time_point committedAt;
+  };
+} // namespace fw16led::managers
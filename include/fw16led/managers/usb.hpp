@@ -1,17 +1,47 @@
 #pragma once
 
 #include "fw16led/LedPanel.hpp"
+#include "fw16led/ledmatrix/engine.hpp"
+#include "fw16led/managers/identity.hpp"
+#include "fw16led/managers/scheduler.hpp"
+#include <QTimer>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace fw16led::managers
 {
+  /**
+   * @brief Panel id addressing every connected panel at once.
+   */
+  inline constexpr uint8_t ALL_PANELS = 0xFF;
+
+  /**
+   * @brief Owns the libusb context and the lifecycle of all connected LED panels.
+   *
+   * Panels are discovered through libusb hotplug events where the platform supports them,
+   * so matrices attached after startup or re-enumerated after a suspend show up on their own.
+   * Panels are always created and destroyed on the Qt main thread and rendered by the FrameScheduler.
+   *
+   * Setting the environment variable FW16LED_SIMULATED_PANELS to a number adds that many
+   * simulated panels, which allows running the application without any hardware. Setting
+   * FW16LED_METRICS_FILE to a path makes the metrics of all panels be written there as JSON
+   * once per second.
+   */
   class UsbManager
   {
   public:
+    using PanelListener = std::function<void(std::shared_ptr<LedPanel>)>;
+
     UsbManager();
     ~UsbManager();
 
+    /**
+     * @brief Start discovering panels. Requires a running Qt application.
+     */
+    void start();
+
     auto get_ledpanels() -> std::vector<std::shared_ptr<LedPanel>>
     {
       return ledpanels;
@@ -19,8 +49,83 @@ namespace fw16led::managers
 
     void applyConfig(uint8_t panelId);
 
+    /**
+     * @brief Call a function for the panel with the given id, or for every panel if it is ALL_PANELS.
+     *
+     * The scheduler is woken up afterwards, so changes made through the panel are picked up right away.
+     * @return Whether any panel matched.
+     */
+    template <typename F>
+    auto withPanels(uint8_t panelId, F&& function) -> bool
+    {
+      bool found = false;
+      for (const auto& panel : ledpanels)
+      {
+        if (panelId == ALL_PANELS || panel->getId() == panelId)
+        {
+          function(*panel);
+          found = true;
+        }
+      }
+      if (found)
+        scheduler.wake();
+      return found;
+    }
+
+    /**
+     * @brief Render a canvas preset across all panels, see PanelSpan.
+     */
+    void startSpan(std::unique_ptr<CanvasPreset> preset);
+
+    /**
+     * @brief Show a canvas across all panels, see PanelSpan::show().
+     */
+    void showCanvas(const ledmatrix::Canvas& canvas);
+
+    /**
+     * @brief Stop the span and go back to the presets configured for each panel.
+     */
+    void stopSpan();
+
+    auto getSpanStats() -> SpanStats { return scheduler.get_span().get_stats(); }
+
+    /**
+     * @brief Let a producer process write frames for a panel into shared memory, see SharedFrameRing.
+     * @param prefix Start of the shared memory object's name, including the leading slash.
+     * @return Name of the panel's shared memory object, or an empty string if there is no such
+     * panel or the object could not be created.
+     */
+    auto mapSharedFrames(uint8_t panelId, const std::string& prefix) -> std::string;
+
+    /**
+     * @brief Register a listener that is called after a panel was created, before it is first rendered.
+     */
+    void onPanelAdded(PanelListener listener) { panelAddedListeners.push_back(std::move(listener)); }
+
+    /**
+     * @brief Register a listener that is called before a panel is destroyed.
+     */
+    void onPanelRemoved(PanelListener listener) { panelRemovedListeners.push_back(std::move(listener)); }
+
   private:
+    static int LIBUSB_CALL on_hotplug(libusb_context* context, libusb_device* device, libusb_hotplug_event event, void* userData);
+
+    void scan();
+    void attach(libusb_device* device, int attempt = 0);
+    void detach(libusb_device* device);
+    void addSimulatedPanels(int count);
+    void addPanel(std::shared_ptr<LedPanel> panel);
+    auto attachedIds() const -> std::vector<uint8_t>;
+
     std::vector<std::shared_ptr<LedPanel>> ledpanels;
-    libusb_context* libusb_ctx;
+    FrameScheduler scheduler;
+    std::vector<PanelListener> panelAddedListeners;
+    std::vector<PanelListener> panelRemovedListeners;
+    PanelIdentityStore identities;
+    libusb_context* libusb_ctx = nullptr;
+    std::unique_ptr<ledmatrix::TransferEngine> engine;
+    std::unique_ptr<QTimer> metricsTimer;
+    libusb_hotplug_callback_handle hotplugHandle{};
+    bool hotplugRegistered = false;
   };
-} // namespace fw16led::managers
\ No newline at end of file
+} // namespace fw16led::managers
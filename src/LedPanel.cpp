@@ -1,13 +1,17 @@
 #include "fw16led/LedPanel.hpp"
 #include "fw16led/PresetRegistry.hpp"
 #include "fw16led/global.hpp"
+#include <utility>
 
 namespace fw16led
 {
-  static uint8_t nextId = 0;
+  /**
+   * @brief Keep-alives due within this window are sent early, so that panels share wakeups.
+   */
+  inline constexpr auto KEEP_ALIVE_COALESCE_WINDOW = std::chrono::seconds(5);
 
-  LedPanel::LedPanel(std::shared_ptr<ledmatrix::LedMatrix> ledMatrix)
-    : id(++nextId)
+  LedPanel::LedPanel(uint8_t id, std::shared_ptr<ledmatrix::LedMatrix> ledMatrix)
+    : id(id)
     , ledMatrix(ledMatrix)
     , currentPreset(nullptr)
   {
@@ -17,49 +21,224 @@ namespace fw16led
 
   LedPanel::~LedPanel()
   {
+    // Stop the preset before the panel it renders to goes away
+    if (currentPreset)
+    {
+      currentPreset->exit();
+    }
   }
 
   void LedPanel::applyConfig()
   {
     LOG_INFO("Applying config to LedPanel with id: {}", id);
 
+    auto brightness = settings->value(QString("panel_%1_brightness").arg(id), 150).toInt();
+
+    auto newPresetName = settings->value(QString("panel_%1_preset").arg(id), "off").toString();
+    auto newPresetNameStdString = newPresetName.toStdString();
+
+    // Apply settings
+    std::unordered_map<std::string, PresetOptionValue> options;
+    for (const auto& option : preset_registry->getOptions(newPresetNameStdString))
+    {
+      auto optionName = QString("panel_%1_preset_%2_%3").arg(id).arg(newPresetName).arg(QString::fromStdString(option.key));
+      switch (option.type)
+      {
+      case PresetOptionType::Checkbox:
+        options[option.key] = settings->value(optionName, option.defaultBool).toBool();
+        break;
+      case PresetOptionType::NumberRange:
+        options[option.key] = settings->value(optionName, option.defaultNumber).toDouble();
+        break;
+      case PresetOptionType::Text:
+        options[option.key] = settings->value(optionName, QString::fromStdString(option.defaultText)).toString().toStdString();
+        break;
+      case PresetOptionType::Dropdown:
+        options[option.key] = settings->value(optionName, option.defaultDropdown).toInt();
+        break;
+      }
+    }
+
+    applyPreset(newPresetNameStdString, options, static_cast<uint8_t>(brightness));
+  }
+
+  bool LedPanel::applyPreset(const std::string& presetId, const std::unordered_map<std::string, PresetOptionValue>& options, std::optional<uint8_t> brightness)
+  {
+    bool exists = preset_registry->find(presetId) != nullptr;
+
+    // The render thread picks it up on its next tick, replacing any config it did not get to yet
+    std::lock_guard lock(configMutex);
+    pendingConfig = PendingConfig{presetId, options, brightness};
+    generation++;
+    return exists;
+  }
+
+  void LedPanel::setBrightness(uint8_t brightness)
+  {
+    std::lock_guard lock(configMutex);
+    pendingBrightness = brightness;
+  }
+
+  void LedPanel::showFrame(const ledmatrix::Frame& frame)
+  {
+    auto& back = streamedFrames.back();
+    back.grey = false;
+    back.frame = frame;
+    publish(back);
+  }
+
+  void LedPanel::showGreyFrame(const ledmatrix::Framebuffer& frame)
+  {
+    auto& back = streamedFrames.back();
+    back.grey = true;
+    back.greyFrame = frame;
+    publish(back);
+  }
+
+  void LedPanel::attachSharedFrames(std::unique_ptr<managers::SharedFrameRing> ring)
+  {
+    sharedFramesName = ring ? ring->get_name() : std::string();
+
+    // The ring is only read on the render thread, a ring replaced here is released there as well
+    std::lock_guard lock(configMutex);
+    pendingSharedFrames = std::move(ring);
+  }
+
+  void LedPanel::publish(StreamedFrame& frame)
+  {
+    frame.generation = generation.load();
+    streamedFrames.publish();
+  }
+
+  void LedPanel::install(PendingConfig config, Preset::TimePoint now)
+  {
     if (currentPreset)
     {
       currentPreset->exit();
       currentPreset = nullptr;
     }
 
-    auto brightness = settings->value(QString("panel_%1_brightness").arg(id), 150).toInt();
-    ledMatrix->brightness(brightness);
+    if (config.brightness)
+      ledMatrix->brightness(*config.brightness);
     ledMatrix->animate(false);
 
-    auto newPresetName = settings->value(QString("panel_%1_preset").arg(id), "off").toString();
-    auto newPresetNameStdString = newPresetName.toStdString();
-    currentPreset = preset_registry->createPreset(newPresetNameStdString);
+    currentPreset = preset_registry->createPreset(config.presetId);
     if (currentPreset)
     {
-      // Apply settings
-      for (auto option : preset_registry->getOptions(newPresetNameStdString))
+      for (const auto& [key, value] : config.options)
+        currentPreset->setOptionValue(key, value);
+      currentPreset->init(ledMatrix);
+    }
+
+    // Render the first frame right away
+    nextFrame = now;
+    streaming = false;
+
+    // Like streamed frames, frames published into the ring before the preset are outdated
+    if (sharedFrames)
+      sharedFramesSeen = sharedFrames->get_published();
+  }
+
+  void LedPanel::suspendPreset()
+  {
+    if (!streaming && currentPreset)
+    {
+      currentPreset->exit();
+      currentPreset = nullptr;
+    }
+    streaming = true;
+  }
+
+  void LedPanel::show(const StreamedFrame& frame)
+  {
+    suspendPreset();
+    if (frame.grey)
+      ledMatrix->draw_grey(frame.greyFrame);
+    else
+      ledMatrix->draw(frame.frame);
+    checkFirstFrame();
+  }
+
+  void LedPanel::showSpanned(const ledmatrix::Framebuffer& frame)
+  {
+    suspendPreset();
+    ledMatrix->draw_grey(frame);
+    checkFirstFrame();
+  }
+
+  void LedPanel::checkFirstFrame()
+  {
+    if (firstFrameSent || ledMatrix->get_frame_stats().sent == 0)
+      return;
+
+    firstFrameSent = true;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startup_time);
+    LOG_INFO("First frame on LedPanel with id {} sent {} ms after startup", id, elapsed.count());
+  }
+
+  auto LedPanel::tick(Preset::TimePoint now) -> std::optional<Preset::TimePoint>
+  {
+    std::optional<PendingConfig> config;
+    std::optional<uint8_t> brightness;
+    std::unique_ptr<managers::SharedFrameRing> ring;
+    {
+      std::lock_guard lock(configMutex);
+      // A span owns the panel until it stops, its preset is only installed afterwards
+      if (!spanned)
       {
-        auto optionName = QString("panel_%1_preset_%2_%3").arg(id).arg(newPresetName).arg(QString::fromStdString(option.key));
-        switch (option.type)
-        {
-        case PresetOptionType::Checkbox:
-          currentPreset->setOptionValue(option.key, settings->value(optionName, option.defaultBool).toBool());
-          break;
-        case PresetOptionType::NumberRange:
-          currentPreset->setOptionValue(option.key, settings->value(optionName, option.defaultNumber).toDouble());
-          break;
-        case PresetOptionType::Text:
-          currentPreset->setOptionValue(option.key, settings->value(optionName, QString::fromStdString(option.defaultText)).toString().toStdString());
-          break;
-        case PresetOptionType::Dropdown:
-          currentPreset->setOptionValue(option.key, settings->value(optionName, option.defaultDropdown).toInt());
-          break;
-        }
+        config = std::exchange(pendingConfig, std::nullopt);
+        installedGeneration = generation.load();
       }
+      brightness = std::exchange(pendingBrightness, std::nullopt);
+      ring = std::move(pendingSharedFrames);
+    }
+    if (ring)
+    {
+      // Only frames published after attaching are shown
+      sharedFramesSeen = ring->get_published();
+      sharedFrames = std::move(ring);
+    }
+    if (config)
+      install(std::move(*config), now);
+    if (brightness)
+      ledMatrix->brightness(*brightness);
 
-      currentPreset->init(ledMatrix);
+    // Frames streamed in before the current preset was applied are outdated
+    if (streamedFrames.take() && streamedFrames.front().generation == installedGeneration)
+      show(streamedFrames.front());
+
+    // Copied out of the ring first, so the producer cannot overwrite a frame while it is sent
+    if (sharedFrames && sharedFrames->take_latest(sharedFramesSeen, sharedFrame.grey, sharedFrame.frame, sharedFrame.greyFrame))
+      show(sharedFrame);
+
+    if (streaming)
+    {
+      // Streamed frames come whenever the producer sends them, only the keep-alive is scheduled
+      nextFrame.reset();
     }
+    else
+    {
+      if (!currentPreset)
+        return std::nullopt;
+
+      if (nextFrame && *nextFrame <= now)
+      {
+        nextFrame = currentPreset->render(now);
+        checkFirstFrame();
+      }
+
+      if (!currentPreset->keepsAwake())
+        return nextFrame;
+    }
+
+    // Any frame sent counts as keeping the panel awake
+    auto keepAliveDue = ledMatrix->get_last_transfer() + ledmatrix::KEEP_ALIVE_INTERVAL;
+    if (keepAliveDue - KEEP_ALIVE_COALESCE_WINDOW <= now)
+    {
+      ledMatrix->keep_awake();
+      keepAliveDue = now + ledmatrix::KEEP_ALIVE_INTERVAL;
+    }
+
+    return nextFrame ? std::min(*nextFrame, keepAliveDue) : keepAliveDue;
   }
 } // namespace fw16led
\ No newline at end of file
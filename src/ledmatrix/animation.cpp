@@ -0,0 +1,174 @@
+#include "fw16led/ledmatrix/animation.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace fw16led::ledmatrix
+{
+  // Frames are handed out as references into the file, so they must be plain bytes
+  static_assert(std::endian::native == std::endian::little, "Animation files are little endian");
+  static_assert(sizeof(Frame) == FRAME_SIZE && alignof(Frame) == 1 && std::is_trivially_copyable_v<Frame>);
+  static_assert(sizeof(Framebuffer) == PIXELS && alignof(Framebuffer) == 1 && std::is_trivially_copyable_v<Framebuffer>);
+
+  inline constexpr uint16_t MAX_DURATION_MS = UINT16_MAX;
+
+  namespace
+  {
+    auto frame_size(AnimationFormat format) -> size_t
+    {
+      return format == AnimationFormat::Grey ? PIXELS : FRAME_SIZE;
+    }
+  } // namespace
+
+  auto AnimationView::parse(std::span<const uint8_t> data) -> std::optional<AnimationView>
+  {
+    AnimationHeader header;
+    if (data.size() < sizeof(header))
+    {
+      LOG_DEBUG("Animation is shorter than its header");
+      return std::nullopt;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != AnimationHeader::MAGIC || header.version != AnimationHeader::VERSION)
+    {
+      LOG_DEBUG("Animation has an unknown magic or version {}", header.version);
+      return std::nullopt;
+    }
+    if (header.format != AnimationFormat::Bits && header.format != AnimationFormat::Grey)
+    {
+      LOG_DEBUG("Animation has an unknown format {}", static_cast<int>(header.format));
+      return std::nullopt;
+    }
+
+    uint64_t tableEnd = sizeof(AnimationHeader) + uint64_t(header.frameCount) * sizeof(AnimationFrameEntry);
+    if (header.frameCount == 0 || tableEnd > data.size())
+    {
+      LOG_DEBUG("Animation has {} frames, its table does not fit", header.frameCount);
+      return std::nullopt;
+    }
+
+    AnimationView view;
+    view.data = data;
+    view.format = header.format;
+    view.frameCount = header.frameCount;
+
+    // Checking the table up front lets playback index the data without any further checks
+    size_t size = frame_size(header.format);
+    for (size_t i = 0; i < view.frameCount; ++i)
+    {
+      auto entry = view.entry(i);
+      if (entry.offset < tableEnd || entry.offset + size > data.size() || entry.durationMs == 0)
+      {
+        LOG_DEBUG("Animation frame {} at {} is out of bounds or has no duration", i, entry.offset);
+        return std::nullopt;
+      }
+    }
+    return view;
+  }
+
+  auto AnimationView::entry(size_t index) const -> AnimationFrameEntry
+  {
+    AnimationFrameEntry entry;
+    std::memcpy(&entry, data.data() + sizeof(AnimationHeader) + index * sizeof(AnimationFrameEntry), sizeof(entry));
+    return entry;
+  }
+
+  auto AnimationView::duration(size_t index) const -> std::chrono::milliseconds
+  {
+    return std::chrono::milliseconds(entry(index).durationMs);
+  }
+
+  auto AnimationView::bits(size_t index) const -> const Frame&
+  {
+    return *reinterpret_cast<const Frame*>(data.data() + entry(index).offset);
+  }
+
+  auto AnimationView::grey(size_t index) const -> const Framebuffer&
+  {
+    return *reinterpret_cast<const Framebuffer*>(data.data() + entry(index).offset);
+  }
+
+  AnimationWriter::AnimationWriter(AnimationFormat format)
+    : format(format)
+  {
+  }
+
+  void AnimationWriter::add(const Frame& frame, std::chrono::milliseconds duration)
+  {
+    if (format != AnimationFormat::Bits)
+    {
+      LOG_ERROR("Cannot add a 1-bit frame to a greyscale animation");
+      return;
+    }
+    append(frame, duration);
+  }
+
+  void AnimationWriter::add(const Framebuffer& framebuffer, std::chrono::milliseconds duration)
+  {
+    if (format != AnimationFormat::Grey)
+    {
+      LOG_ERROR("Cannot add a greyscale frame to a 1-bit animation");
+      return;
+    }
+    append(framebuffer.data(), duration);
+  }
+
+  void AnimationWriter::append(std::span<const uint8_t> frame, std::chrono::milliseconds duration)
+  {
+    auto hash = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(frame.data()), frame.size()));
+    std::optional<uint32_t> offset;
+    auto [first, last] = offsetsByHash.equal_range(hash);
+    for (auto it = first; it != last; ++it)
+    {
+      if (std::equal(frame.begin(), frame.end(), frames.begin() + it->second))
+      {
+        offset = it->second;
+        break;
+      }
+    }
+    if (!offset)
+    {
+      offset = static_cast<uint32_t>(frames.size());
+      frames.insert(frames.end(), frame.begin(), frame.end());
+      offsetsByHash.emplace(hash, *offset);
+    }
+
+    // Durations longer than an entry can hold are split over several entries of the same frame
+    auto remaining = std::max<int64_t>(duration.count(), 1);
+    if (!entries.empty() && entries.back().offset == *offset)
+    {
+      auto extra = std::min<int64_t>(remaining, MAX_DURATION_MS - entries.back().durationMs);
+      entries.back().durationMs += static_cast<uint16_t>(extra);
+      remaining -= extra;
+    }
+    while (remaining > 0)
+    {
+      auto part = std::min<int64_t>(remaining, MAX_DURATION_MS);
+      entries.push_back({.offset = *offset, .durationMs = static_cast<uint16_t>(part)});
+      remaining -= part;
+    }
+  }
+
+  auto AnimationWriter::finish() const -> std::vector<uint8_t>
+  {
+    AnimationHeader header;
+    header.format = format;
+    header.frameCount = static_cast<uint32_t>(entries.size());
+    size_t tableEnd = sizeof(header) + entries.size() * sizeof(AnimationFrameEntry);
+
+    std::vector<uint8_t> file(tableEnd);
+    std::memcpy(file.data(), &header, sizeof(header));
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+      auto entry = entries[i];
+      entry.offset += static_cast<uint32_t>(tableEnd);
+      std::memcpy(file.data() + sizeof(header) + i * sizeof(entry), &entry, sizeof(entry));
+    }
+    file.insert(file.end(), frames.begin(), frames.end());
+    return file;
+  }
+} // namespace fw16led::ledmatrix
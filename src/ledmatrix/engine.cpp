@@ -0,0 +1,99 @@
+#include "fw16led/ledmatrix/engine.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <optional>
+
+namespace fw16led::ledmatrix
+{
+  TransferEngine::TransferEngine(libusb_context* context)
+    : context(context)
+    , thread(&TransferEngine::run, this)
+  {
+  }
+
+  TransferEngine::~TransferEngine()
+  {
+    LOG_DEBUG("Stopping USB event thread");
+    running = false;
+    libusb_interrupt_event_handler(context);
+    thread.join();
+  }
+
+  auto TransferEngine::post_at(Clock::time_point when, std::function<void()> task) -> TaskId
+  {
+    TaskId id;
+    bool earliest;
+    {
+      std::lock_guard lock(mutex);
+      id = nextTaskId++;
+      auto it = tasks.emplace(when, Task{id, std::move(task)});
+      earliest = it == tasks.begin();
+    }
+
+    // Wake the event loop up so it can shorten its timeout
+    if (earliest)
+      libusb_interrupt_event_handler(context);
+    return id;
+  }
+
+  auto TransferEngine::cancel(TaskId id) -> bool
+  {
+    std::lock_guard lock(mutex);
+    auto it = std::find_if(tasks.begin(), tasks.end(), [id](const auto& entry)
+                           { return entry.second.id == id; });
+    if (it == tasks.end())
+      return false;
+    tasks.erase(it);
+    return true;
+  }
+
+  void TransferEngine::run_due_tasks()
+  {
+    while (true)
+    {
+      Task task;
+      {
+        std::lock_guard lock(mutex);
+        if (tasks.empty() || tasks.begin()->first > Clock::now())
+          return;
+        task = std::move(tasks.begin()->second);
+        tasks.erase(tasks.begin());
+      }
+      task.run();
+    }
+  }
+
+  void TransferEngine::run()
+  {
+    LOG_DEBUG("USB event thread started");
+    while (running)
+    {
+      run_due_tasks();
+
+      std::optional<std::chrono::microseconds> wait;
+      {
+        std::lock_guard lock(mutex);
+        if (!tasks.empty())
+          wait = std::max(std::chrono::duration_cast<std::chrono::microseconds>(tasks.begin()->first - Clock::now()), std::chrono::microseconds(0));
+      }
+
+      // Without tasks only transfers, hotplug events, post_at() and the destructor wake the thread up.
+      // An interrupt that arrives before handling starts makes the next call return right away.
+      int r;
+      if (wait)
+      {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(*wait);
+        timeval timeout{static_cast<time_t>(seconds.count()), static_cast<suseconds_t>((*wait - seconds).count())};
+        r = libusb_handle_events_timeout_completed(context, &timeout, nullptr);
+      }
+      else
+      {
+        r = libusb_handle_events_completed(context, nullptr);
+      }
+      if (r != LIBUSB_SUCCESS && r != LIBUSB_ERROR_INTERRUPTED)
+      {
+        LOG_WARN("Handling USB events failed: {}", libusb_strerror(static_cast<libusb_error>(r)));
+      }
+    }
+  }
+} // namespace fw16led::ledmatrix
@@ -1,159 +1,280 @@
 #include "fw16led/ledmatrix/ledmatrix.hpp"
-#include "fw16led/ledmatrix/font.hpp"
-#include <codecvt>
+#include "fw16led/ledmatrix/text.hpp"
 
 namespace fw16led::ledmatrix
 {
-  inline constexpr std::array<uint8_t, 2> FWK_MAGIG = {0x32, 0xAC};
-  inline constexpr uint8_t RESPONSE_SIZE = 32;
-  inline constexpr uint8_t ENDPOINT_OUT = 0x01;
-  inline constexpr uint8_t ENDPOINT_IN = 0x82;
-  inline constexpr int TRANSFER_TIMEOUT_MS = 100;
-
-  LedMatrix::~LedMatrix()
+  /**
+   * @brief Whether a command may change what the panel displays, making the cached frame stale.
+   */
+  auto changes_display(Command command, std::span<const uint8_t> parameters) -> bool
   {
-    // Reset the device
-    if (int r = libusb_reset_device(device.get()); r != LIBUSB_SUCCESS)
+    switch (command)
     {
-      LOG_WARN("Could not reset device: {}", libusb_strerror(static_cast<libusb_error>(r)));
+    case Command::Brightness:
+    case Command::Version:
+    case Command::PwmFreq:
+    case Command::SetFps:
+    case Command::SetPowerMode:
+    case Command::DebugMode:
+    case Command::GameStatus:
+      return false;
+    case Command::Sleep:
+      // Waking the panel up keeps its contents, putting it to sleep does not
+      return parameters.empty() || parameters[0] != 0x00;
+    default:
+      return true;
     }
+  }
 
-    // Release the interface
-    if (int r = libusb_release_interface(device.get(), 1); r != LIBUSB_SUCCESS)
+  /**
+   * @brief Frequency in Hz of a PwmFreq setting, or -1 if the value is unknown.
+   */
+  auto pwm_freq_hz(uint8_t value) -> int
+  {
+    switch (value)
     {
-      LOG_WARN("Could not release interface: {}", libusb_strerror(static_cast<libusb_error>(r)));
+    case 0:
+      return 29000;
+    case 1:
+      return 3600;
+    case 2:
+      return 1800;
+    case 3:
+      return 900;
+    default:
+      return -1;
     }
+  }
+
+  /**
+   * @brief Settings that can be read back, in the order refresh_state() queries them.
+   */
+  inline constexpr std::array<Command, 3> STATE_QUERIES = {Command::Brightness, Command::Animate, Command::PwmFreq};
 
-#ifdef __linux__
-    // Re-attach kernel driver
-    if (int r = libusb_attach_kernel_driver(device.get(), 1); r != LIBUSB_SUCCESS)
+  void LedMatrix::draw(const Frame& frame)
+  {
+    auto now = std::chrono::steady_clock::now();
+    if (lastFrame == frame && now - lastTransfer < KEEP_ALIVE_INTERVAL)
     {
-      LOG_WARN("Could not attach kernel driver: {}", libusb_strerror(static_cast<libusb_error>(r)));
+      framesElided.fetch_add(1, std::memory_order_relaxed);
+      LOG_TRACE("Skipping unchanged frame ({} elided so far)", framesElided.load());
+      return;
     }
-#endif
+
+    // Frames are swapped into the transport without locking or allocating, its engine thread queues them
+    track_command(Command::Draw, frame);
+    LOG_TRACE("Sending frame");
+    transport->submit_frame(frame);
+    lastFrame = frame;
+    framesSent.fetch_add(1, std::memory_order_relaxed);
   }
 
-  void LedMatrix::send_command(Command command, const std::vector<uint8_t>& parameters)
+  void LedMatrix::draw_grey(const Framebuffer& framebuffer)
   {
-    // Build the outgoing data packet
-    std::vector<uint8_t> outData;
-    outData.reserve(FWK_MAGIG.size() + 1 + parameters.size());
-    outData.insert(outData.end(), FWK_MAGIG.begin(), FWK_MAGIG.end());
-    outData.push_back(static_cast<uint8_t>(command));
-    outData.insert(outData.end(), parameters.begin(), parameters.end());
-
-    LOG_TRACE("Sending command {} with {} parameters", static_cast<int>(command), parameters.size());
-
-    // Send the data via bulk OUT transfer
-    int actual_length = 0;
-    int ret = libusb_bulk_transfer(device.get(), ENDPOINT_OUT, outData.data(), static_cast<int>(outData.size()), &actual_length, TRANSFER_TIMEOUT_MS);
-    if (ret != LIBUSB_SUCCESS || actual_length != static_cast<int>(outData.size()))
+    // A commit the transport gave up on leaves the staged columns in the device's buffer
+    if (greyCommitFailed.exchange(false, std::memory_order_acq_rel))
     {
-      LOG_WARN("Bulk OUT transfer failed or size mismatch: {}", libusb_strerror(static_cast<libusb_error>(ret)));
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      return send_command(command, parameters);
+      stagedGrey.reset();
+      shownGrey.reset();
     }
-  }
 
-  auto LedMatrix::send_command_with_response(Command command, const std::vector<uint8_t>& parameters) -> std::vector<uint8_t>
-  {
-    // Build the outgoing data packet
-    std::vector<uint8_t> outData;
-    outData.reserve(FWK_MAGIG.size() + 1 + parameters.size());
-    outData.insert(outData.end(), FWK_MAGIG.begin(), FWK_MAGIG.end());
-    outData.push_back(static_cast<uint8_t>(command));
-    outData.insert(outData.end(), parameters.begin(), parameters.end());
+    auto now = std::chrono::steady_clock::now();
+    if (shownGrey == framebuffer && now - lastTransfer < KEEP_ALIVE_INTERVAL)
+    {
+      framesElided.fetch_add(1, std::memory_order_relaxed);
+      LOG_TRACE("Skipping unchanged greyscale frame ({} elided so far)", framesElided.load());
+      return;
+    }
 
-    LOG_TRACE("Sending command {} with {} parameters", static_cast<int>(command), parameters.size());
+    // One StageGreyCol per column that differs from the buffer plus the commit, each parameter list being [column, brightness...]
+    std::array<std::array<uint8_t, 1 + HEIGHT>, WIDTH> columns;
+    std::array<Transport::Request, WIDTH + 1> requests;
+    size_t count = 0;
 
-    // Send the data via bulk OUT transfer
-    int actual_length = 0;
-    int ret = libusb_bulk_transfer(device.get(), ENDPOINT_OUT, outData.data(), static_cast<int>(outData.size()), &actual_length, TRANSFER_TIMEOUT_MS);
-    if (ret != LIBUSB_SUCCESS || actual_length != static_cast<int>(outData.size()))
+    for (int x = 0; x < WIDTH; ++x)
     {
-      LOG_WARN("Bulk OUT transfer failed or size mismatch: {}", libusb_strerror(static_cast<libusb_error>(ret)));
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      return send_command_with_response(command, parameters);
-    }
+      if (stagedGrey && stagedGrey->column_equals(framebuffer, x))
+        continue;
 
-    std::vector<uint8_t> inData(RESPONSE_SIZE, 0);
+      auto& column = columns[count];
+      column[0] = static_cast<uint8_t>(x);
+      std::ranges::copy(framebuffer.column(x), column.begin() + 1);
+      requests[count++] = {Command::StageGreyCol, column};
+    }
 
-    ret = libusb_bulk_transfer(device.get(), ENDPOINT_IN, inData.data(), RESPONSE_SIZE, &actual_length, TRANSFER_TIMEOUT_MS);
+    static constexpr std::array<uint8_t, 1> COMMIT = {0x00};
+    requests[count++] = {Command::DrawGreyColBuffer, COMMIT, nullptr, [this]()
+                         { greyCommitFailed.store(true, std::memory_order_release); }};
 
-    if (ret != LIBUSB_SUCCESS)
+    LOG_TRACE("Drawing greyscale frame with {} staged columns", count - 1);
+    if (!transport->submit_batch(std::span(requests.data(), count)))
     {
-      LOG_WARN("Bulk IN transfer failed: {}", libusb_strerror(static_cast<libusb_error>(ret)));
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      return send_command_with_response(command, parameters);
+      // The device may hold any mix of old and new columns now
+      stagedGrey.reset();
+      return;
     }
 
-    // Shrink the buffer to the actual number of bytes read
-    inData.resize(actual_length);
-    return inData;
+    lastFrame.reset();
+    lastTransfer = now;
+    stagedGrey = Framebuffer{};
+    shownGrey = framebuffer;
+    framesSent.fetch_add(1, std::memory_order_relaxed);
   }
 
-  auto splitUTF8(const std::string& input) -> std::vector<std::string>
+  void LedMatrix::track_command(Command command, std::span<const uint8_t> parameters)
   {
-    std::vector<std::string> result;
-    std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> converter;
-
-    try
+    if (changes_display(command, parameters))
     {
-      // Convert UTF-8 string to a wide string (char32_t for full Unicode (Needed for vowel mutations))
-      std::u32string wideStr = converter.from_bytes(input);
-
-      for (auto ch : wideStr)
-      {
-        result.push_back(converter.to_bytes(ch));
-      }
+      lastFrame.reset();
+      shownGrey.reset();
     }
-    catch (const std::range_error& e)
+    if (command == Command::StageGreyCol || command == Command::DrawGreyColBuffer)
     {
-      LOG_ERROR("Error processing string: {}", e.what());
+      // Raw column commands bypass draw_grey(), so its copy of the column buffer is stale
+      stagedGrey.reset();
     }
-
-    return result;
+    if (!parameters.empty())
+    {
+      // Setting a value is the same as reading it back afterwards
+      record_response(command, parameters);
+    }
+    lastTransfer = std::chrono::steady_clock::now();
   }
 
-  void LedMatrix::pattern_text(const std::string& text)
+  void LedMatrix::record_response(Command command, std::span<const uint8_t> response)
   {
-    LOG_TRACE("Setting text to {}", text);
-    auto parts = splitUTF8(text);
-    this->pattern_symbols(parts);
+    if (response.empty())
+      return;
+
+    std::lock_guard lock(stateMutex);
+    switch (command)
+    {
+    case Command::Brightness:
+      deviceState.brightness = response[0];
+      break;
+    case Command::Animate:
+      deviceState.animating = response[0] == 0x01;
+      break;
+    case Command::PwmFreq:
+      if (int hz = pwm_freq_hz(response[0]); hz > 0)
+        deviceState.pwmFreq = hz;
+      break;
+    case Command::Sleep:
+      deviceState.sleeping = response[0] == 0x01;
+      break;
+    default:
+      break;
+    }
   }
 
-  void LedMatrix::pattern_symbols(std::vector<std::string>& parts)
+  void LedMatrix::send_command(Command command, const std::vector<uint8_t>& parameters)
   {
-    std::vector<std::reference_wrapper<const std::array<bool, FONT_PIXELS>>> font_items;
+    track_command(command, parameters);
+    LOG_TRACE("Sending command {} with {} parameters", static_cast<int>(command), parameters.size());
+    transport->submit(command, parameters);
+  }
 
-    for (size_t i = 0; i < std::min(parts.size(), size_t(5)); ++i)
+  auto LedMatrix::send_command_with_response(Command command, const std::vector<uint8_t>& parameters) -> std::vector<uint8_t>
+  {
+    auto response = this->query(command, parameters);
+    if (response.wait_for(RESPONSE_TIMEOUT) != std::future_status::ready)
     {
-      font_items.push_back(std::cref(get_char(parts[i])));
+      LOG_WARN("No response to command {} within {} ms", static_cast<int>(command), RESPONSE_TIMEOUT.count());
+      return {};
     }
 
-    std::vector<uint8_t> vals(39, 0x00);
+    auto result = response.get();
+    if (parameters.empty())
+      record_response(command, result);
+    return result;
+  }
 
-    for (size_t digit_i = 0; digit_i < font_items.size(); ++digit_i)
+  auto LedMatrix::query_batch(std::span<const Command> commands) -> std::vector<std::vector<uint8_t>>
+  {
+    std::vector<std::future<std::vector<uint8_t>>> futures;
+    std::vector<Transport::Request> requests;
+    futures.reserve(commands.size());
+    requests.reserve(commands.size());
+    for (auto command : commands)
     {
-      const auto& digit_pixels = font_items[digit_i].get();
-      size_t offset = digit_i * 7;
+      auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+      futures.push_back(promise->get_future());
+      requests.push_back({command, {}, [promise](std::vector<uint8_t> response)
+                          { promise->set_value(std::move(response)); }});
+      track_command(command, {});
+    }
+
+    std::vector<std::vector<uint8_t>> responses(commands.size());
+    LOG_TRACE("Querying {} commands in one batch", commands.size());
+    if (!transport->submit_batch(requests))
+      return responses;
 
-      for (size_t pixel_x = 0; pixel_x < FONT_WIDTH; ++pixel_x)
+    // All queries share one deadline, the batch takes as long as its slowest answer
+    auto deadline = std::chrono::steady_clock::now() + RESPONSE_TIMEOUT;
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+      if (futures[i].wait_until(deadline) != std::future_status::ready)
       {
-        for (size_t pixel_y = 0; pixel_y < FONT_HEIGHT; ++pixel_y)
-        {
-          bool pixel_value = digit_pixels[pixel_x + pixel_y * FONT_WIDTH];
-          size_t i = (2 + pixel_x) + (9 * (pixel_y + offset));
-
-          if (pixel_value)
-          {
-            vals[i / 8] |= (1 << (i % 8));
-          }
-        }
+        LOG_WARN("No response to command {} within {} ms", static_cast<int>(commands[i]), RESPONSE_TIMEOUT.count());
+        continue;
       }
+      responses[i] = futures[i].get();
+      record_response(commands[i], responses[i]);
     }
+    return responses;
+  }
+
+  auto LedMatrix::refresh_state() -> DeviceState
+  {
+    query_batch(STATE_QUERIES);
+    return get_state();
+  }
 
-    this->send_command(Command::Draw, vals);
+  auto LedMatrix::get_brightness() -> uint8_t
+  {
+    LOG_TRACE("Getting current global brightness");
+    auto value = get_state().brightness;
+    if (!value)
+      value = refresh_state().brightness;
+    return value.value_or(0);
+  }
+
+  auto LedMatrix::get_animate() -> bool
+  {
+    LOG_TRACE("Getting current animation status");
+    auto value = get_state().animating;
+    if (!value)
+      value = refresh_state().animating;
+    return value.value_or(false);
+  }
+
+  auto LedMatrix::query(Command command, const std::vector<uint8_t>& parameters) -> std::future<std::vector<uint8_t>>
+  {
+    track_command(command, parameters);
+    LOG_TRACE("Querying command {} with {} parameters", static_cast<int>(command), parameters.size());
+    return transport->submit_with_response(command, parameters);
+  }
+
+  void LedMatrix::query(Command command, const std::vector<uint8_t>& parameters, Transport::ResponseCallback onResponse)
+  {
+    track_command(command, parameters);
+    LOG_TRACE("Querying command {} with {} parameters", static_cast<int>(command), parameters.size());
+    transport->submit(command, parameters, std::move(onResponse));
+  }
+
+  void LedMatrix::pattern_text(std::string_view text)
+  {
+    LOG_TRACE("Setting text to {}", text);
+    Frame vals{};
+    render_text(text, vals);
+    this->draw(vals);
+  }
+
+  void LedMatrix::pattern_symbols(std::span<const std::string_view> parts)
+  {
+    Frame vals{};
+    render_symbols(parts, vals);
+    this->draw(vals);
   }
 
   void LedMatrix::pattern_count(int value)
@@ -165,7 +286,7 @@ namespace fw16led::ledmatrix
       return;
     }
 
-    std::vector<uint8_t> vals(39, 0x00);
+    Frame vals{};
 
     for (int byte = 0; byte < value / CHAR_BIT; ++byte)
     {
@@ -176,70 +297,49 @@ namespace fw16led::ledmatrix
       vals[value / 8] += 1 << i;
     }
 
-    this->send_command(Command::Draw, vals);
+    this->draw(vals);
   }
 
   auto LedMatrix::get_pwm_freq() -> int
   {
-    auto res = this->send_command_with_response(Command::PwmFreq);
-    if (res.empty())
-      return -1;
-
-    switch (res[0])
-    {
-    case 0:
-      return 29000;
-    case 1:
-      return 3600;
-    case 2:
-      return 1800;
-    case 3:
-      return 900;
-    default:
-      return -1;
-    }
+    auto value = get_state().pwmFreq;
+    if (!value)
+      value = refresh_state().pwmFreq;
+    return value.value_or(-1);
   }
 
-  void LedMatrix::pattern_matrix(std::vector<bool>& matrix)
+  void LedMatrix::pattern_matrix(const MatrixBitmap& matrix)
   {
-    LOG_TRACE("Setting pattern to matrix with {} values", matrix.size());
-    std::vector<uint8_t> vals(39, 0x00);
-
-    for (int x = 0; x < WIDTH; ++x)
-    {
-      for (int y = 0; y < HEIGHT; ++y)
-      {
-        int i = x + y * WIDTH;
-        if (matrix[i])
-          vals[i / 8] |= (1 << (i % 8));
-      }
-    }
-
-    this->send_command(Command::Draw, vals);
+    LOG_TRACE("Setting pattern to matrix");
+    this->draw(matrix.data());
   }
 
-  void LedMatrix::pattern_equalizer(std::vector<uint8_t>& values)
+  void LedMatrix::pattern_equalizer(std::span<const uint8_t> values)
   {
     LOG_TRACE("Setting pattern to equalizer with {} values", values.size());
-    std::vector<bool> matrix(PIXELS, false);
-    for (int col = 0; col < std::min(values.size(), static_cast<std::size_t>(9)); ++col)
+    // Bars grow from the middle, with the extra pixel of odd values going up. Each bar toggles
+    // its column on at its first row and off after its last one.
+    std::array<uint64_t, HEIGHT + 1> edges{};
+    for (int col = 0; col < std::min(static_cast<int>(values.size()), WIDTH); ++col)
     {
-      int val = values[col];
-
-      int row = HEIGHT / 2;
-      int above = val / 2;
-      int below = val - above;
-
-      for (int i = 0; i < above; i++)
+      int above = values[col] / 2;
+      int below = values[col] - above;
+      int top = std::max(HEIGHT / 2 - below, 0);
+      int bottom = std::min(HEIGHT / 2 + above, HEIGHT);
+      if (top < bottom)
       {
-        matrix[col + (row + i) * WIDTH] = true;
+        edges[top] ^= uint64_t(1) << col;
+        edges[bottom] ^= uint64_t(1) << col;
       }
+    }
 
-      for (int i = 0; i < below; i++)
-      {
-        matrix[col + (row - 1 - i) * WIDTH] = true;
-      }
+    MatrixBitmap matrix;
+    uint64_t row = 0;
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+      row ^= edges[y];
+      matrix.write_row(y, row);
     }
     this->pattern_matrix(matrix);
   }
-} // namespace fw16led::ledmatrix
\ No newline at end of file
+} // namespace fw16led::ledmatrix
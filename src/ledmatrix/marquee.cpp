@@ -0,0 +1,46 @@
+#include "fw16led/ledmatrix/marquee.hpp"
+#include "fw16led/ledmatrix/text.hpp"
+#include "fw16led/ledmatrix/utf8.hpp"
+
+namespace fw16led::ledmatrix
+{
+  Marquee::Marquee(std::string_view text)
+  {
+    for (std::string_view rest = text; !rest.empty();)
+    {
+      const Glyph& glyph = get_char(next_code_point(rest));
+      for (int y = 0; y < TEXT_LINE_HEIGHT; ++y)
+      {
+        rows.push_back(y < FONT_HEIGHT ? MIRRORED_ROWS[glyph[y]] << TEXT_LEFT : 0);
+      }
+    }
+    rows.resize(rows.size() + HEIGHT, 0);
+  }
+
+  void Marquee::render(int step, Frame& frame) const
+  {
+    size_t row = static_cast<size_t>(step) % rows.size();
+
+    // Rows are WIDTH bits wide and packed back to back, so they are streamed through an accumulator
+    uint32_t bits = 0;
+    int pending = 0;
+    size_t byte = 0;
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+      bits |= static_cast<uint32_t>(rows[row]) << pending;
+      pending += WIDTH;
+      while (pending >= 8)
+      {
+        frame[byte++] = static_cast<uint8_t>(bits);
+        bits >>= 8;
+        pending -= 8;
+      }
+
+      // The strip is at least HEIGHT rows long, so the window wraps around at most once
+      if (++row == rows.size())
+        row = 0;
+    }
+    if (pending > 0)
+      frame[byte] = static_cast<uint8_t>(bits);
+  }
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,249 @@
+#include "fw16led/ledmatrix/simulator.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace fw16led::ledmatrix
+{
+  /**
+   * @brief Version the simulated firmware reports, encoded like the real one.
+   */
+  inline constexpr std::array<uint8_t, 3> SIMULATED_VERSION = {0x00, 0x11, 0x00};
+
+  SimulatedPanel::SimulatedPanel(uint32_t seed)
+    : random(seed)
+  {
+  }
+
+  auto SimulatedPanel::receive(std::span<const uint8_t> packet) -> std::optional<std::array<uint8_t, RESPONSE_SIZE>>
+  {
+    std::lock_guard lock(mutex);
+    packetsReceived++;
+    bytesReceived += packet.size();
+
+    if (packet.size() <= FWK_MAGIG.size() || !std::equal(FWK_MAGIG.begin(), FWK_MAGIG.end(), packet.begin()))
+    {
+      LOG_WARN("Simulated panel received a malformed packet of {} bytes", packet.size());
+      return std::nullopt;
+    }
+
+    auto command = static_cast<Command>(packet[FWK_MAGIG.size()]);
+    auto parameters = packet.subspan(FWK_MAGIG.size() + 1);
+
+    // Commands without parameters are queries, answered with the current value
+    auto getOrSet = [&](auto& value) -> std::optional<std::array<uint8_t, RESPONSE_SIZE>>
+    {
+      if (parameters.empty())
+      {
+        std::array<uint8_t, RESPONSE_SIZE> response{};
+        response[0] = static_cast<uint8_t>(value);
+        return response;
+      }
+      value = static_cast<std::remove_reference_t<decltype(value)>>(parameters[0]);
+      return std::nullopt;
+    };
+
+    switch (command)
+    {
+    case Command::Brightness:
+      return getOrSet(brightness);
+    case Command::Sleep:
+      return getOrSet(sleeping);
+    case Command::Animate:
+      return getOrSet(animating);
+    case Command::PwmFreq:
+      return getOrSet(pwmFreq);
+    case Command::Pattern:
+      if (!parameters.empty())
+        pattern = static_cast<IntegratedPattern>(parameters[0]);
+      return std::nullopt;
+    case Command::Draw:
+    {
+      if (parameters.size() < FRAME_SIZE)
+        return std::nullopt;
+
+      Framebuffer pixels;
+      for (int y = 0; y < HEIGHT; ++y)
+      {
+        for (int x = 0; x < WIDTH; ++x)
+        {
+          int i = x + y * WIDTH;
+          pixels.at(x, y) = (parameters[i / 8] >> (i % 8)) & 1 ? 0xFF : 0x00;
+        }
+      }
+      show(pixels);
+      return std::nullopt;
+    }
+    case Command::StageGreyCol:
+      if (parameters.size() >= 1 + HEIGHT && parameters[0] < WIDTH)
+      {
+        for (int y = 0; y < HEIGHT; ++y)
+          columnBuffer.at(parameters[0], y) = parameters[1 + y];
+      }
+      return std::nullopt;
+    case Command::DrawGreyColBuffer:
+      // Like the firmware, start every greyscale frame from a dark column buffer
+      show(columnBuffer);
+      columnBuffer = Framebuffer{};
+      return std::nullopt;
+    case Command::Version:
+    {
+      std::array<uint8_t, RESPONSE_SIZE> response{};
+      std::copy(SIMULATED_VERSION.begin(), SIMULATED_VERSION.end(), response.begin());
+      return response;
+    }
+    default:
+      return std::nullopt;
+    }
+  }
+
+  void SimulatedPanel::show(const Framebuffer& pixels)
+  {
+    pattern.reset();
+    frames.push_back({std::chrono::steady_clock::now(), pixels});
+    if (frames.size() > FRAME_HISTORY)
+      frames.pop_front();
+  }
+
+  void SimulatedPanel::set_faults(const SimulatedFaults& faults)
+  {
+    std::lock_guard lock(mutex);
+    this->faults = faults;
+  }
+
+  void SimulatedPanel::unplug()
+  {
+    std::lock_guard lock(mutex);
+    plugged = false;
+  }
+
+  auto SimulatedPanel::next_transfer() -> std::pair<std::chrono::microseconds, std::optional<TransferFailure>>
+  {
+    std::lock_guard lock(mutex);
+    if (!plugged)
+      return {std::chrono::microseconds(0), TransferFailure::NoDevice};
+
+    auto latency = faults.latency;
+    if (faults.jitter.count() > 0)
+      latency += std::chrono::microseconds(std::uniform_int_distribution<int64_t>(0, faults.jitter.count())(random));
+
+    std::optional<TransferFailure> failure;
+    if (faults.failureRate > 0.0 && std::bernoulli_distribution(faults.failureRate)(random))
+      failure = faults.failure;
+
+    return {latency, failure};
+  }
+
+  auto SimulatedPanel::get_frames() const -> std::vector<SimulatedFrame>
+  {
+    std::lock_guard lock(mutex);
+    return {frames.begin(), frames.end()};
+  }
+
+  void SimulatedPanel::clear_frames()
+  {
+    std::lock_guard lock(mutex);
+    frames.clear();
+  }
+
+  auto SimulatedPanel::get_brightness() const -> uint8_t
+  {
+    std::lock_guard lock(mutex);
+    return brightness;
+  }
+
+  auto SimulatedPanel::is_sleeping() const -> bool
+  {
+    std::lock_guard lock(mutex);
+    return sleeping;
+  }
+
+  auto SimulatedPanel::is_animating() const -> bool
+  {
+    std::lock_guard lock(mutex);
+    return animating;
+  }
+
+  auto SimulatedPanel::get_pattern() const -> std::optional<IntegratedPattern>
+  {
+    std::lock_guard lock(mutex);
+    return pattern;
+  }
+
+  auto SimulatedPanel::get_packets_received() const -> uint64_t
+  {
+    std::lock_guard lock(mutex);
+    return packetsReceived;
+  }
+
+  auto SimulatedPanel::get_bytes_received() const -> uint64_t
+  {
+    std::lock_guard lock(mutex);
+    return bytesReceived;
+  }
+
+  SimulatedTransport::SimulatedTransport(std::shared_ptr<SimulatedPanel> panel, TransferEngine& engine, RetryPolicy retryPolicy)
+    : Transport(engine, retryPolicy)
+    , panel(std::move(panel))
+  {
+  }
+
+  SimulatedTransport::~SimulatedTransport()
+  {
+    close();
+  }
+
+  auto SimulatedTransport::begin_out(std::span<const uint8_t> packet) -> std::optional<TransferFailure>
+  {
+    auto [latency, failure] = panel->next_transfer();
+
+    // The queue keeps the packet alive until the transfer completed, just like libusb requires
+    task = engine.post_at(TransferEngine::Clock::now() + latency, [this, packet, failure]()
+                          {
+                            int length = 0;
+                            if (!failure)
+                            {
+                              response = panel->receive(packet);
+                              length = static_cast<int>(packet.size());
+                            }
+                            transfer_done(failure, length); });
+    return std::nullopt;
+  }
+
+  auto SimulatedTransport::begin_in(std::span<uint8_t> buffer) -> std::optional<TransferFailure>
+  {
+    auto [latency, failure] = panel->next_transfer();
+    if (!failure && !response)
+    {
+      // The firmware only answers queries, so reading after anything else times out
+      latency = std::chrono::milliseconds(TRANSFER_TIMEOUT_MS);
+      failure = TransferFailure::Timeout;
+    }
+
+    task = engine.post_at(TransferEngine::Clock::now() + latency, [this, buffer, failure]()
+                          {
+                            int length = 0;
+                            if (!failure)
+                            {
+                              std::copy(response->begin(), response->end(), buffer.begin());
+                              length = RESPONSE_SIZE;
+                              response.reset();
+                            }
+                            transfer_done(failure, length); });
+    return std::nullopt;
+  }
+
+  void SimulatedTransport::cancel_transfer()
+  {
+    // A transfer that is already completing reports its own result instead
+    if (engine.cancel(task))
+    {
+      task = engine.post_at(TransferEngine::Clock::now(), [this]()
+                            { transfer_done(TransferFailure::Cancelled, 0); });
+    }
+  }
+
+  void SimulatedTransport::clear_halt(uint8_t /*endpoint*/)
+  {
+  }
+} // namespace fw16led::ledmatrix
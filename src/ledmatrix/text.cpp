@@ -0,0 +1,36 @@
+#include "fw16led/ledmatrix/text.hpp"
+#include "fw16led/ledmatrix/utf8.hpp"
+#include <algorithm>
+
+namespace fw16led::ledmatrix
+{
+  void draw_glyph(Frame& frame, const Glyph& glyph, int x, int y)
+  {
+    // A glyph row never covers more than two bytes of the frame
+    for (int pixel_y = 0; pixel_y < FONT_HEIGHT; ++pixel_y)
+    {
+      int i = x + WIDTH * (y + pixel_y);
+      unsigned bits = MIRRORED_ROWS[glyph[pixel_y]] << (i % 8);
+      frame[i / 8] |= static_cast<uint8_t>(bits);
+      if (i / 8 + 1 < FRAME_SIZE)
+        frame[i / 8 + 1] |= static_cast<uint8_t>(bits >> 8);
+    }
+  }
+
+  void render_text(std::string_view text, Frame& frame)
+  {
+    for (int line = 0; line < TEXT_MAX_GLYPHS && !text.empty(); ++line)
+    {
+      draw_glyph(frame, get_char(next_code_point(text)), TEXT_LEFT, line * TEXT_LINE_HEIGHT);
+    }
+  }
+
+  void render_symbols(std::span<const std::string_view> symbols, Frame& frame)
+  {
+    int count = std::min(static_cast<int>(symbols.size()), TEXT_MAX_GLYPHS);
+    for (int line = 0; line < count; ++line)
+    {
+      draw_glyph(frame, get_char(symbols[line]), TEXT_LEFT, line * TEXT_LINE_HEIGHT);
+    }
+  }
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,447 @@
+#include "fw16led/ledmatrix/transport.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+namespace fw16led::ledmatrix
+{
+  inline constexpr auto CLOSE_TIMEOUT = std::chrono::seconds(1);
+
+  Transport::Transport(TransferEngine& engine, RetryPolicy retryPolicy)
+    : engine(engine)
+    , retryPolicy(retryPolicy)
+  {
+  }
+
+  void Transport::submit(Command command, std::span<const uint8_t> parameters)
+  {
+    submit(command, parameters, nullptr);
+  }
+
+  void Transport::submit(Command command, std::span<const uint8_t> parameters, ResponseCallback onResponse)
+  {
+    size_t length = FWK_MAGIG.size() + 1 + parameters.size();
+    if (length > MAX_PACKET_SIZE)
+    {
+      LOG_ERROR("Command {} with {} parameters exceeds the maximum packet size", static_cast<int>(command), parameters.size());
+      if (onResponse)
+        onResponse({});
+      return;
+    }
+
+    std::unique_lock lock(mutex);
+    if (closing || state == LinkState::Disconnected)
+    {
+      lock.unlock();
+      LOG_TRACE("Dropping command {} for disconnected device", static_cast<int>(command));
+      if (onResponse)
+        onResponse({});
+      return;
+    }
+
+    // A frame handed over earlier has to reach the device before this command
+    take_frame();
+    if (!enqueue(command, parameters, onResponse))
+    {
+      lock.unlock();
+      if (onResponse)
+        onResponse({});
+      return;
+    }
+
+    LOG_TRACE("Queued command {} with {} parameters ({} pending)", static_cast<int>(command), parameters.size(), count);
+
+    Completions done;
+    start_next(done);
+    lock.unlock();
+
+    for (auto& [callback, response] : done)
+      callback(std::move(response));
+  }
+
+  auto Transport::submit_with_response(Command command, std::span<const uint8_t> parameters) -> std::future<std::vector<uint8_t>>
+  {
+    auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    auto future = promise->get_future();
+    submit(command, parameters, [promise](std::vector<uint8_t> response)
+           { promise->set_value(std::move(response)); });
+    return future;
+  }
+
+  auto Transport::submit_batch(std::span<const Request> requests) -> bool
+  {
+    for (const auto& request : requests)
+    {
+      if (FWK_MAGIG.size() + 1 + request.parameters.size() > MAX_PACKET_SIZE)
+      {
+        LOG_ERROR("Command {} with {} parameters exceeds the maximum packet size", static_cast<int>(request.command), request.parameters.size());
+        return false;
+      }
+    }
+
+    std::unique_lock lock(mutex);
+    if (closing || state == LinkState::Disconnected)
+      return false;
+
+    take_frame();
+    if (QUEUE_CAPACITY - count < requests.size())
+    {
+      LOG_WARN("Command queue too full for a batch of {} commands", requests.size());
+      return false;
+    }
+
+    for (const auto& request : requests)
+    {
+      Packet& packet = queue[(head + count) % QUEUE_CAPACITY];
+      fill_packet(packet, request.command, request.parameters);
+      packet.onResponse = request.onResponse;
+      packet.onFailure = request.onFailure;
+      count++;
+    }
+
+    LOG_TRACE("Queued batch of {} commands ({} pending)", requests.size(), count);
+
+    Completions done;
+    start_next(done);
+    lock.unlock();
+
+    for (auto& [callback, response] : done)
+      callback(std::move(response));
+    return true;
+  }
+
+  void Transport::submit_frame(const Frame& frame)
+  {
+    if (state == LinkState::Disconnected)
+      return;
+
+    frames.back() = frame;
+    frames.publish();
+
+    // One task moves the frame into the queue, frames published until it runs go along with it
+    if (!framePending.exchange(true, std::memory_order_acq_rel))
+    {
+      pumpTask = engine.post_at(Clock::now(), [this]()
+                                { pump_frame(); });
+    }
+  }
+
+  auto Transport::enqueue(Command command, std::span<const uint8_t> parameters, ResponseCallback& onResponse) -> bool
+  {
+    // A newer frame supersedes one that is still waiting in the queue
+    if (command == Command::Draw && !onResponse && count > (busy ? 1 : 0))
+    {
+      Packet& last = queue[(head + count - 1) % QUEUE_CAPACITY];
+      if (last.command == Command::Draw && !last.onResponse)
+      {
+        fill_packet(last, command, parameters);
+        return true;
+      }
+    }
+
+    if (count == QUEUE_CAPACITY)
+    {
+      LOG_WARN("Command queue full, dropping command {}", static_cast<int>(command));
+      return false;
+    }
+
+    Packet& packet = queue[(head + count) % QUEUE_CAPACITY];
+    fill_packet(packet, command, parameters);
+    packet.onResponse = std::move(onResponse);
+    packet.onFailure = nullptr;
+    count++;
+    return true;
+  }
+
+  void Transport::take_frame()
+  {
+    if (closing || state == LinkState::Disconnected || !frames.take())
+      return;
+
+    ResponseCallback none;
+    enqueue(Command::Draw, frames.front(), none);
+  }
+
+  void Transport::pump_frame()
+  {
+    Completions done;
+    std::unique_lock lock(mutex);
+
+    // Frames published after this point schedule another pump
+    framePending.exchange(false, std::memory_order_acq_rel);
+    if (closing)
+    {
+      idle.notify_all();
+      return;
+    }
+
+    take_frame();
+    start_next(done);
+    lock.unlock();
+
+    for (auto& [callback, response] : done)
+      callback(std::move(response));
+  }
+
+  void Transport::fill_packet(Packet& packet, Command command, std::span<const uint8_t> parameters)
+  {
+    packet.command = command;
+    packet.length = static_cast<uint8_t>(FWK_MAGIG.size() + 1 + parameters.size());
+    packet.attempts = 0;
+    std::copy(FWK_MAGIG.begin(), FWK_MAGIG.end(), packet.data.begin());
+    packet.data[FWK_MAGIG.size()] = static_cast<uint8_t>(command);
+    std::copy(parameters.begin(), parameters.end(), packet.data.begin() + FWK_MAGIG.size() + 1);
+  }
+
+  void Transport::close()
+  {
+    Completions done;
+
+    std::unique_lock lock(mutex);
+    closing = true;
+
+    // Fail everything that has not been handed to the backend yet
+    while (count > (busy ? 1 : 0))
+    {
+      Packet& packet = queue[(head + count - 1) % QUEUE_CAPACITY];
+      fail(packet, done);
+      packet.onResponse = nullptr;
+      packet.onFailure = nullptr;
+      count--;
+    }
+
+    if (busy)
+    {
+      if (stage != Stage::Backoff)
+      {
+        cancel_transfer();
+      }
+      else if (engine.cancel(retryTask))
+      {
+        retryTask = 0;
+        finish(false, {}, done);
+      }
+    }
+
+    if (framePending && engine.cancel(pumpTask))
+    {
+      framePending = false;
+    }
+
+    // Otherwise the transfer, the retry task or the pump task is about to notice that we are closing
+    if (!idle.wait_for(lock, CLOSE_TIMEOUT, [this]()
+                       { return !busy && !framePending; }))
+    {
+      LOG_WARN("Transfer did not finish after being cancelled");
+    }
+    lock.unlock();
+
+    for (auto& [callback, response] : done)
+      callback(std::move(response));
+  }
+
+  void Transport::transfer_done(std::optional<TransferFailure> failure, int length)
+  {
+    Completions done;
+    std::unique_lock lock(mutex);
+
+    Packet& packet = queue[head];
+    if (!failure && stage == Stage::Out && length == packet.length)
+    {
+      stats.packetsSent++;
+      stats.bytesSent += length;
+      if (auto index = static_cast<size_t>(packet.command); index < COMMAND_COUNT)
+        stats.commandsSent[index]++;
+    }
+
+    if (failure)
+    {
+      handle_failure(*failure, done);
+    }
+    else if (stage == Stage::Out && length != packet.length)
+    {
+      LOG_WARN("Bulk OUT transfer size mismatch: sent {} of {} bytes", length, packet.length);
+      handle_failure(TransferFailure::Other, done);
+    }
+    else if (stage == Stage::Out && packet.onResponse && !closing)
+    {
+      // Read the response before sending anything else
+      stage = Stage::In;
+      if (auto submitFailure = begin_in(responseBuffer))
+      {
+        handle_failure(*submitFailure, done);
+      }
+    }
+    else if (stage == Stage::In)
+    {
+      finish(true, std::vector<uint8_t>(responseBuffer.begin(), responseBuffer.begin() + length), done);
+    }
+    else
+    {
+      finish(true, {}, done);
+    }
+
+    start_next(done);
+    lock.unlock();
+
+    for (auto& [callback, response] : done)
+      callback(std::move(response));
+  }
+
+  void Transport::retry()
+  {
+    Completions done;
+    std::unique_lock lock(mutex);
+    retryTask = 0;
+
+    if (haltedEndpoint != 0 && !closing)
+    {
+      // Clearing the halt may block, so it happens outside of the lock
+      uint8_t endpoint = std::exchange(haltedEndpoint, 0);
+      lock.unlock();
+      clear_halt(endpoint);
+      lock.lock();
+    }
+
+    if (closing)
+    {
+      finish(false, {}, done);
+    }
+    else
+    {
+      // Restart the head packet from its OUT transfer
+      busy = false;
+      start_next(done);
+    }
+    lock.unlock();
+
+    for (auto& [callback, response] : done)
+      callback(std::move(response));
+  }
+
+  void Transport::start_next(Completions& done)
+  {
+    // Pick up frames published while the previous transfer was in flight without waiting for the pump
+    take_frame();
+    while (!busy && !closing && count > 0 && state == LinkState::Connected)
+    {
+      Packet& packet = queue[head];
+      if (packet.attempts++ == 0)
+        packet.firstAttempt = Clock::now();
+
+      busy = true;
+      stage = Stage::Out;
+      if (auto failure = begin_out(std::span(packet.data.data(), packet.length)))
+      {
+        handle_failure(*failure, done);
+      }
+    }
+  }
+
+  void Transport::handle_failure(TransferFailure failure, Completions& done)
+  {
+    Packet& packet = queue[head];
+
+    if (failure == TransferFailure::Cancelled || closing)
+    {
+      finish(false, {}, done);
+      return;
+    }
+
+    if (failure == TransferFailure::NoDevice)
+    {
+      disconnect(done);
+      return;
+    }
+
+    if (failure == TransferFailure::Timeout)
+      stats.timeouts++;
+
+    auto elapsed = Clock::now() - packet.firstAttempt;
+    if (retryPolicy.should_retry(failure, packet.attempts, elapsed))
+    {
+      auto delay = retryPolicy.backoff(packet.attempts);
+      LOG_DEBUG("Command {} failed ({}), retrying in {} ms (attempt {} of {})", static_cast<int>(packet.command), failure_name(failure), delay.count(), packet.attempts + 1, retryPolicy.maxAttempts);
+
+      stats.retries++;
+      if (failure == TransferFailure::Pipe)
+        haltedEndpoint = stage == Stage::In ? ENDPOINT_IN : ENDPOINT_OUT;
+      stage = Stage::Backoff;
+      retryTask = engine.post_at(Clock::now() + delay, [this]()
+                                 { retry(); });
+      return;
+    }
+
+    LOG_WARN("Giving up on command {} after {} attempts: {}", static_cast<int>(packet.command), packet.attempts, failure_name(failure));
+    stats.failures++;
+    finish(false, {}, done);
+  }
+
+  void Transport::finish(bool ok, std::vector<uint8_t> response, Completions& done)
+  {
+    busy = false;
+    Packet packet = pop_front();
+    if (ok)
+    {
+      auto now = Clock::now();
+      stats.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(now - packet.firstAttempt));
+      if (packet.command == Command::Draw || packet.command == Command::DrawGreyColBuffer)
+        lastFrameShown.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+    if (!ok)
+      fail(packet, done);
+    else if (packet.onResponse)
+      done.emplace_back(std::move(packet.onResponse), std::move(response));
+
+    if (closing)
+      idle.notify_all();
+  }
+
+  void Transport::fail(Packet& packet, Completions& done)
+  {
+    if (packet.onResponse)
+      done.emplace_back(std::move(packet.onResponse), std::vector<uint8_t>{});
+    if (packet.onFailure)
+    {
+      done.emplace_back([onFailure = std::move(packet.onFailure)](std::vector<uint8_t>)
+                        { onFailure(); }, std::vector<uint8_t>{});
+    }
+  }
+
+  void Transport::disconnect(Completions& done)
+  {
+    LOG_ERROR("Device disconnected, dropping {} pending commands", count);
+    state = LinkState::Disconnected;
+
+    while (count > 0)
+    {
+      Packet packet = pop_front();
+      fail(packet, done);
+    }
+    busy = false;
+    idle.notify_all();
+  }
+
+  auto Transport::get_stats() -> TransportStats
+  {
+    std::lock_guard lock(mutex);
+    return stats;
+  }
+
+  auto Transport::is_idle() -> bool
+  {
+    std::lock_guard lock(mutex);
+    return !busy;
+  }
+
+  auto Transport::pop_front() -> Packet
+  {
+    Packet packet = std::move(queue[head]);
+    queue[head].onResponse = nullptr;
+    queue[head].onFailure = nullptr;
+    head = (head + 1) % QUEUE_CAPACITY;
+    count--;
+    return packet;
+  }
+} // namespace fw16led::ledmatrix
@@ -0,0 +1,92 @@
+#include "fw16led/ledmatrix/usbtransport.hpp"
+#include "fw16led/global.hpp"
+
+namespace fw16led::ledmatrix
+{
+  LibusbTransport::LibusbTransport(libusb_device_handle* device, TransferEngine& engine, RetryPolicy retryPolicy)
+    : Transport(engine, retryPolicy)
+    , device(device, libusb_close)
+    , transfer(libusb_alloc_transfer(0))
+  {
+  }
+
+  LibusbTransport::~LibusbTransport()
+  {
+    // Make sure no transfer still references the device
+    close();
+
+    // Leaking the transfer is better than freeing it while libusb still owns it
+    if (is_idle())
+    {
+      libusb_free_transfer(transfer);
+    }
+
+    if (get_state() == LinkState::Disconnected)
+    {
+      LOG_DEBUG("Device is gone, skipping reset");
+      return;
+    }
+
+    // Reset the device
+    if (int r = libusb_reset_device(device.get()); r != LIBUSB_SUCCESS)
+    {
+      LOG_WARN("Could not reset device: {}", libusb_strerror(static_cast<libusb_error>(r)));
+    }
+
+    // Release the interface
+    if (int r = libusb_release_interface(device.get(), 1); r != LIBUSB_SUCCESS)
+    {
+      LOG_WARN("Could not release interface: {}", libusb_strerror(static_cast<libusb_error>(r)));
+    }
+
+#ifdef __linux__
+    // Re-attach kernel driver
+    if (int r = libusb_attach_kernel_driver(device.get(), 1); r != LIBUSB_SUCCESS)
+    {
+      LOG_WARN("Could not attach kernel driver: {}", libusb_strerror(static_cast<libusb_error>(r)));
+    }
+#endif
+  }
+
+  auto LibusbTransport::begin_out(std::span<const uint8_t> packet) -> std::optional<TransferFailure>
+  {
+    // libusb never writes to the buffer of an OUT transfer
+    libusb_fill_bulk_transfer(transfer, device.get(), ENDPOINT_OUT, const_cast<uint8_t*>(packet.data()), static_cast<int>(packet.size()), on_transfer_done, this, TRANSFER_TIMEOUT_MS);
+    return submit_transfer();
+  }
+
+  auto LibusbTransport::begin_in(std::span<uint8_t> buffer) -> std::optional<TransferFailure>
+  {
+    libusb_fill_bulk_transfer(transfer, device.get(), ENDPOINT_IN, buffer.data(), static_cast<int>(buffer.size()), on_transfer_done, this, TRANSFER_TIMEOUT_MS);
+    return submit_transfer();
+  }
+
+  auto LibusbTransport::submit_transfer() -> std::optional<TransferFailure>
+  {
+    if (int r = libusb_submit_transfer(transfer); r != LIBUSB_SUCCESS)
+      return classify_failure(static_cast<libusb_error>(r));
+    return std::nullopt;
+  }
+
+  void LibusbTransport::cancel_transfer()
+  {
+    libusb_cancel_transfer(transfer);
+  }
+
+  void LibusbTransport::clear_halt(uint8_t endpoint)
+  {
+    if (int r = libusb_clear_halt(device.get(), endpoint); r != LIBUSB_SUCCESS)
+    {
+      LOG_WARN("Could not clear halt on endpoint {:#04x}: {}", endpoint, libusb_strerror(static_cast<libusb_error>(r)));
+    }
+  }
+
+  void LIBUSB_CALL LibusbTransport::on_transfer_done(libusb_transfer* transfer)
+  {
+    std::optional<TransferFailure> failure;
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED)
+      failure = classify_failure(transfer->status);
+
+    static_cast<LibusbTransport*>(transfer->user_data)->transfer_done(failure, transfer->actual_length);
+  }
+} // namespace fw16led::ledmatrix
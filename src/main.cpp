@@ -1,21 +1,45 @@
+#include "./presets/Animation.hpp"
 #include "./presets/Clock.hpp"
 #include "./presets/Gradient.hpp"
+#include "./presets/Image.hpp"
 #include "./presets/Off.hpp"
+#include "./presets/SystemMonitor.hpp"
 #include "./presets/Text.hpp"
+#include "./presets/Ticker.hpp"
+#include "./presets/Visualiser.hpp"
 #include "./presets/ZigZag.hpp"
 #include "Application.hpp"
 #include "fw16led/PresetRegistry.hpp"
 #include "fw16led/global.hpp"
+#include "fw16led/managers/control.hpp"
+#include "fw16led/managers/identity.hpp"
+#include "fw16led/managers/sampler.hpp"
 #include "fw16led/managers/usb.hpp"
 #include "spdlog/spdlog.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTimer>
+#include <chrono>
+#include <csignal>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <QSocketNotifier>
+#include <unistd.h>
+#endif
 
 std::shared_ptr<spdlog::logger> logger_default;
 std::shared_ptr<fw16led::managers::UsbManager> usb_manager;
 std::shared_ptr<fw16led::PresetRegistry> preset_registry;
 std::shared_ptr<QSettings> settings;
+std::shared_ptr<fw16led::managers::SystemSampler> system_sampler;
+const std::chrono::steady_clock::time_point startup_time = std::chrono::steady_clock::now();
 
 void init_loggers()
 {
@@ -46,6 +70,206 @@ void init_presets()
   fw16led::presets::Gradient::registerPreset(preset_registry);
   fw16led::presets::Text::registerPreset(preset_registry);
   fw16led::presets::Clock::registerPreset(preset_registry);
+  fw16led::presets::SystemMonitor::registerPreset(preset_registry);
+  fw16led::presets::Visualiser::registerPreset(preset_registry);
+  fw16led::presets::Animation::registerPreset(preset_registry);
+  fw16led::presets::Image::registerPreset(preset_registry);
+}
+
+/**
+ * @brief Command line options that have to be known before the Qt application is created.
+ */
+struct Options
+{
+  bool help = false;
+  bool headless = false;                                           /**< Run without a window or control socket. */
+  bool daemon = false;                                             /**< Run without a window, controlled through the socket only. */
+  QString socketName = fw16led::managers::DEFAULT_CONTROL_SOCKET; /**< Name or path of the control socket. */
+  uint8_t panelId = fw16led::managers::ALL_PANELS;                /**< Panel the options below apply to. */
+  std::optional<std::string> presetId;                             /**< Preset to show instead of the one in the settings. */
+  QStringList presetOptions;                                       /**< "key=value" lines for the options of presetId. */
+  std::optional<uint8_t> brightness;                               /**< Brightness to use instead of the one in the settings. */
+  std::optional<std::string> tickerText;                           /**< Text to scroll across all panels. */
+  std::string error;                                               /**< Why the command line is invalid, empty if it is valid. */
+};
+
+/**
+ * @brief Parse an integer option value, if it is one within the given range.
+ */
+std::optional<int> parse_number(const char* value, int min, int max)
+{
+  bool ok = false;
+  int number = QString::fromLocal8Bit(value).toInt(&ok);
+  if (!ok || number < min || number > max)
+    return std::nullopt;
+  return number;
+}
+
+Options parse_options(int argc, char* argv[])
+{
+  Options options;
+  for (int i = 1; i < argc && options.error.empty(); ++i)
+  {
+    std::string_view arg = argv[i];
+    bool takesValue = arg == "--socket" || arg == "--panel" || arg == "--preset" || arg == "--option" || arg == "--ticker" || arg == "--brightness";
+    if (takesValue && i + 1 >= argc)
+    {
+      options.error = std::string(arg) + " needs a value";
+      break;
+    }
+
+    if (arg == "--help" || arg == "-h")
+      options.help = true;
+    else if (arg == "--headless")
+      options.headless = true;
+    else if (arg == "--daemon")
+      options.daemon = true;
+    else if (arg == "--socket")
+      options.socketName = QString::fromLocal8Bit(argv[++i]);
+    else if (arg == "--panel")
+    {
+      // ALL_PANELS is what leaving out --panel means, no panel has that id
+      auto id = parse_number(argv[++i], 0, fw16led::managers::ALL_PANELS - 1);
+      if (id)
+        options.panelId = static_cast<uint8_t>(*id);
+      else
+        options.error = std::string("Invalid panel id '") + argv[i] + "'";
+    }
+    else if (arg == "--preset")
+      options.presetId = argv[++i];
+    else if (arg == "--option")
+      options.presetOptions.append(QString::fromLocal8Bit(argv[++i]));
+    else if (arg == "--ticker")
+      options.tickerText = argv[++i];
+    else if (arg == "--brightness")
+    {
+      auto brightness = parse_number(argv[++i], 0, UINT8_MAX);
+      if (brightness)
+        options.brightness = static_cast<uint8_t>(*brightness);
+      else
+        options.error = std::string("Invalid brightness '") + argv[i] + "', it has to be between 0 and 255";
+    }
+    else
+      options.error = std::string("Unknown argument '") + std::string(arg) + "'";
+  }
+  return options;
+}
+
+void print_usage(const char* program, std::ostream& out)
+{
+  out << "Usage: " << program << " [options]\n"
+      << "  --headless            Run without a window, showing the presets from the settings\n"
+      << "  --daemon              Like --headless, but also listen on the control socket\n"
+      << "  --socket NAME         Name or path of the control socket\n"
+      << "  --preset ID           Show this preset instead of the one in the settings\n"
+      << "  --option KEY=VALUE    Set an option of the preset given with --preset, may be repeated\n"
+      << "  --brightness VALUE    Use this brightness (0-255) instead of the one in the settings\n"
+      << "  --panel ID            Apply --preset and --brightness to this panel only\n"
+      << "  --ticker TEXT         Scroll text across all panels, from the right to the left\n";
+}
+
+/**
+ * @brief Show the preset and brightness given on the command line on every matching panel as it shows up.
+ * @return Whether the preset and its options are valid.
+ */
+bool apply_overrides(const Options& options)
+{
+  if (!options.presetId && !options.brightness)
+    return true;
+
+  std::optional<std::unordered_map<std::string, fw16led::PresetOptionValue>> presetOptions;
+  if (options.presetId)
+  {
+    if (!preset_registry->find(*options.presetId))
+    {
+      LOG_ERROR("Unknown preset '{}'", *options.presetId);
+      return false;
+    }
+
+    presetOptions = fw16led::managers::parseOptions(*options.presetId, options.presetOptions);
+    if (!presetOptions)
+    {
+      LOG_ERROR("Unknown option for preset '{}'", *options.presetId);
+      return false;
+    }
+  }
+
+  // Panels are configured before their first tick, so the preset from the settings is never shown
+  usb_manager->onPanelAdded([options, presetOptions](std::shared_ptr<fw16led::LedPanel> panel)
+                            {
+                              if (options.panelId != fw16led::managers::ALL_PANELS && panel->getId() != options.panelId)
+                                return;
+                              if (options.presetId)
+                                panel->applyPreset(*options.presetId, *presetOptions, options.brightness);
+                              else
+                                panel->setBrightness(*options.brightness); });
+  return true;
+}
+
+#ifdef __linux__
+namespace
+{
+  int signalPipe[2] = {-1, -1};
+
+  void on_signal(int)
+  {
+    // Only async-signal-safe calls are allowed here, the event loop does the rest
+    char byte = 1;
+    [[maybe_unused]] auto written = ::write(signalPipe[1], &byte, 1);
+  }
+}
+
+/**
+ * @brief Quit the event loop on SIGINT and SIGTERM, so that the panels are released properly.
+ */
+void quit_on_signals()
+{
+  if (::pipe(signalPipe) != 0)
+    return;
+
+  auto* notifier = new QSocketNotifier(signalPipe[0], QSocketNotifier::Read, QCoreApplication::instance());
+  QObject::connect(notifier, &QSocketNotifier::activated, []()
+                   { QCoreApplication::quit(); });
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+}
+#endif
+
+/**
+ * @brief Run without a window, with the panels driven by the presets in the settings and, as a daemon, by control clients.
+ *
+ * Only needs a QCoreApplication, which starts a lot faster than the widget stack and uses far less memory.
+ */
+int run_headless(int argc, char* argv[], const Options& options)
+{
+  QCoreApplication app(argc, argv);
+#ifdef __linux__
+  quit_on_signals();
+#endif
+
+  usb_manager->start();
+
+  std::optional<fw16led::managers::ControlServer> server;
+  if (options.daemon)
+  {
+    server.emplace();
+    if (!server->listen(options.socketName))
+    {
+      server.reset();
+      usb_manager.reset();
+      return 1;
+    }
+  }
+
+  QTimer::singleShot(0, []()
+                     {
+                       auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startup_time);
+                       LOG_INFO("Started in {} ms", elapsed.count()); });
+
+  int result = app.exec();
+  server.reset();
+  usb_manager.reset();
+  return result;
 }
 
 /**
@@ -54,18 +278,60 @@ void init_presets()
  */
 int main(int argc, char* argv[])
 {
+  auto options = parse_options(argc, argv);
+  if (!options.error.empty())
+  {
+    std::cerr << options.error << "\n";
+    print_usage(argv[0], std::cerr);
+    return 1;
+  }
+  if (options.help)
+  {
+    print_usage(argv[0], std::cout);
+    return 0;
+  }
+
   init_loggers();
 
   settings = std::make_shared<QSettings>("framework16-led-matrix-manager", "framework16-led-matrix-manager");
 
+  // Ids are handed out when a panel is first plugged in, so any other id cannot match a panel
+  if (options.panelId != fw16led::managers::ALL_PANELS && !fw16led::managers::PanelIdentityStore().isKnown(options.panelId))
+  {
+    std::cerr << "No panel has the id " << static_cast<int>(options.panelId) << ", start once without --panel to assign ids\n";
+    print_usage(argv[0], std::cerr);
+    return 1;
+  }
+
+  // Opens nothing and starts no thread until a preset subscribes
+  system_sampler = std::make_shared<fw16led::managers::SystemSampler>();
+
   preset_registry = std::make_shared<fw16led::PresetRegistry>();
   init_presets();
   for (const auto& id : preset_registry->getRegisteredPresetIds())
     LOG_INFO("Found Preset '{}'", id);
 
   usb_manager = std::make_shared<fw16led::managers::UsbManager>();
+  if (!apply_overrides(options))
+  {
+    usb_manager.reset();
+    return 1;
+  }
+  if (options.tickerText)
+    usb_manager->startSpan(std::make_unique<fw16led::presets::Ticker>(*options.tickerText));
+
+  if (options.headless || options.daemon)
+    return run_headless(argc, argv, options);
 
   fw16led::Application app(argc, argv);
 
-  return app.exec();
+  // Panels are discovered in the background and show up once the event loop runs
+  usb_manager->start();
+
+  int result = app.exec();
+
+  // Presets own Qt objects, so the panels have to go before the application does
+  usb_manager.reset();
+
+  return result;
 }
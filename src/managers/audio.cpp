@@ -0,0 +1,326 @@
+#include "fw16led/managers/audio.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <map>
+#include <numbers>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fw16led::managers
+{
+  inline constexpr size_t READ_BUFFER_SIZE = 8192;
+  inline constexpr size_t BYTES_PER_SAMPLE = 2;
+
+  /**
+   * @brief Reads per drain of a pipe, so a writer faster than the analysis cannot keep the thread reading forever.
+   */
+  inline constexpr int MAX_READS_PER_DRAIN = 16;
+
+  inline constexpr int POLL_TIMEOUT_MS = 100;
+  inline constexpr auto REOPEN_INTERVAL = std::chrono::milliseconds(250);
+
+  Spectrum::Spectrum(int sampleRate)
+    : window(WINDOW)
+    , reversed(HALF)
+    , unpackRe(HALF)
+    , unpackIm(HALF)
+    , re(HALF)
+    , im(HALF)
+  {
+    // Periodic Hann window
+    for (size_t n = 0; n < WINDOW; ++n)
+      window[n] = 0.5f - 0.5f * std::cos(2.0f * std::numbers::pi_v<float> * n / WINDOW);
+
+    int bits = std::countr_zero(HALF);
+    for (uint32_t i = 0; i < HALF; ++i)
+    {
+      uint32_t r = 0;
+      for (int b = 0; b < bits; ++b)
+        r |= ((i >> b) & 1) << (bits - 1 - b);
+      reversed[i] = r;
+    }
+
+    for (size_t half = 1; half < HALF; half *= 2)
+    {
+      for (size_t j = 0; j < half; ++j)
+      {
+        double angle = -std::numbers::pi * j / half;
+        twiddleRe.push_back(static_cast<float>(std::cos(angle)));
+        twiddleIm.push_back(static_cast<float>(std::sin(angle)));
+      }
+    }
+
+    for (size_t k = 0; k < HALF; ++k)
+    {
+      double angle = -2.0 * std::numbers::pi * k / WINDOW;
+      unpackRe[k] = static_cast<float>(std::cos(angle));
+      unpackIm[k] = static_cast<float>(std::sin(angle));
+    }
+
+    // Log-spaced band edges, every band gets at least one bin even if the low ones are narrower than a bin
+    double binWidth = static_cast<double>(sampleRate) / WINDOW;
+    double highest = std::min<double>(MAX_FREQUENCY, sampleRate / 2.0);
+    size_t first = std::max<size_t>(1, std::lround(MIN_FREQUENCY / binWidth));
+    for (size_t band = 0; band < BANDS; ++band)
+    {
+      double edge = MIN_FREQUENCY * std::pow(highest / MIN_FREQUENCY, static_cast<double>(band + 1) / BANDS);
+      size_t last = std::clamp<size_t>(std::lround(edge / binWidth), std::min(first + 1, HALF), HALF);
+      binRanges[band] = {first, last};
+      first = last;
+    }
+  }
+
+  namespace
+  {
+    /**
+     * @brief One run of radix-2 butterflies, combining a with b twiddled into a + b and a - b.
+     *
+     * The halves never overlap, and saying so with __restrict on the parameters is what lets the
+     * compiler vectorise this. Restrict on local pointers is ignored by GCC.
+     */
+    void butterflies(float* __restrict ar, float* __restrict ai, float* __restrict br, float* __restrict bi, const float* __restrict wr, const float* __restrict wi, size_t count)
+    {
+      for (size_t j = 0; j < count; ++j)
+      {
+        float tr = br[j] * wr[j] - bi[j] * wi[j];
+        float ti = br[j] * wi[j] + bi[j] * wr[j];
+        br[j] = ar[j] - tr;
+        bi[j] = ai[j] - ti;
+        ar[j] += tr;
+        ai[j] += ti;
+      }
+    }
+  } // namespace
+
+  void Spectrum::transform()
+  {
+    // Iterative radix-2 decimation in time on bit reversed input
+    size_t offset = 0;
+    for (size_t half = 1; half < HALF; half *= 2)
+    {
+      for (size_t start = 0; start < HALF; start += 2 * half)
+        butterflies(re.data() + start, im.data() + start, re.data() + start + half, im.data() + start + half, twiddleRe.data() + offset, twiddleIm.data() + offset, half);
+      offset += half;
+    }
+  }
+
+  void Spectrum::analyse(std::span<const float, WINDOW> samples, Levels& levels)
+  {
+    // Even samples go into the real part and odd ones into the imaginary part of a half size FFT
+    for (size_t n = 0; n < HALF; ++n)
+    {
+      re[reversed[n]] = samples[2 * n] * window[2 * n];
+      im[reversed[n]] = samples[2 * n + 1] * window[2 * n + 1];
+    }
+    transform();
+
+    // A full scale sine peaks at WINDOW / 4 after the Hann window
+    constexpr float reference = (WINDOW / 4.0f) * (WINDOW / 4.0f);
+    for (size_t band = 0; band < BANDS; ++band)
+    {
+      float power = 0.0f;
+      for (size_t k = binRanges[band].first; k < binRanges[band].second; ++k)
+      {
+        // Separate the spectra of the even and odd samples and combine them into bin k of the real FFT
+        float sumRe = re[k] + re[HALF - k];
+        float sumIm = im[k] - im[HALF - k];
+        float diffRe = re[k] - re[HALF - k];
+        float diffIm = im[k] + im[HALF - k];
+        float oddRe = diffIm * unpackRe[k] + diffRe * unpackIm[k];
+        float oddIm = diffIm * unpackIm[k] - diffRe * unpackRe[k];
+        float xr = 0.5f * (sumRe + oddRe);
+        float xi = 0.5f * (sumIm + oddIm);
+        power += xr * xr + xi * xi;
+      }
+
+      float db = 10.0f * std::log10(power / reference + 1e-12f);
+      levels[band] = std::clamp((db + RANGE_DB) / RANGE_DB, 0.0f, 1.0f);
+    }
+  }
+
+  AudioCapture::AudioCapture(std::string path, int sampleRate)
+    : path(std::move(path))
+    , sampleRate(std::max(sampleRate, 1))
+    , hop(std::max(this->sampleRate / HOP_RATE, 1))
+    , spectrum(this->sampleRate)
+    , history(Spectrum::WINDOW, 0.0f)
+    , windowed(Spectrum::WINDOW)
+    , buffer(READ_BUFFER_SIZE)
+  {
+#ifdef __linux__
+    thread = std::thread(&AudioCapture::run, this);
+#else
+    LOG_WARN("Audio capture is only supported on Linux");
+#endif
+  }
+
+  AudioCapture::~AudioCapture()
+  {
+    stopping = true;
+    if (thread.joinable())
+      thread.join();
+    close_source();
+  }
+
+  auto AudioCapture::share(const std::string& path, int sampleRate) -> std::shared_ptr<AudioCapture>
+  {
+    static std::mutex capturesMutex;
+    static std::map<std::pair<std::string, int>, std::weak_ptr<AudioCapture>> captures;
+
+    std::lock_guard lock(capturesMutex);
+    auto& shared = captures[{path, sampleRate}];
+    auto capture = shared.lock();
+    if (!capture)
+    {
+      capture = std::make_shared<AudioCapture>(path, sampleRate);
+      shared = capture;
+    }
+    return capture;
+  }
+
+  auto AudioCapture::get_analysis() -> Analysis
+  {
+    std::lock_guard lock(mutex);
+    return analysis;
+  }
+
+  void AudioCapture::run()
+  {
+    bool reported = false;
+    size_t pending = 0;
+    while (!stopping)
+    {
+      if (fd < 0 && !open_source())
+      {
+        if (!reported)
+          LOG_WARN("Waiting for audio at {}", path);
+        reported = true;
+        std::this_thread::sleep_for(REOPEN_INTERVAL);
+        continue;
+      }
+
+      long count = read_source();
+      if (count < 0)
+      {
+        LOG_DEBUG("Audio source {} closed, reopening", path);
+        close_source();
+        std::this_thread::sleep_for(REOPEN_INTERVAL);
+        continue;
+      }
+
+      pending += count;
+      if (pending < hop)
+        continue;
+      pending = 0;
+
+      // Oldest sample first
+      std::copy(history.begin() + historyEnd, history.end(), windowed.begin());
+      std::copy(history.begin(), history.begin() + historyEnd, windowed.end() - historyEnd);
+
+      Spectrum::Levels levels;
+      spectrum.analyse(std::span<const float, Spectrum::WINDOW>(windowed.data(), Spectrum::WINDOW), levels);
+
+      std::lock_guard lock(mutex);
+      analysis.levels = levels;
+      analysis.time = std::chrono::steady_clock::now();
+      analysis.sequence++;
+    }
+  }
+
+  auto AudioCapture::open_source() -> bool
+  {
+#ifdef __linux__
+    // Non-blocking, so that opening a pipe does not wait for a writer
+    fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+
+    struct stat info{};
+    regularFile = ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+    buffered = 0;
+    LOG_INFO("Reading audio from {} at {} Hz", path, sampleRate);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void AudioCapture::close_source()
+  {
+#ifdef __linux__
+    if (fd >= 0)
+      ::close(fd);
+#endif
+    fd = -1;
+  }
+
+  auto AudioCapture::read_source() -> long
+  {
+#ifdef __linux__
+    if (regularFile)
+    {
+      // Files are played back at the sample rate, one hop at a time
+      std::this_thread::sleep_for(std::chrono::microseconds(1'000'000 / HOP_RATE));
+      size_t wanted = std::min(hop * BYTES_PER_SAMPLE, buffer.size());
+      ssize_t length = ::read(fd, buffer.data(), wanted);
+      if (length == 0 && ::lseek(fd, 0, SEEK_SET) == 0)
+        length = ::read(fd, buffer.data(), wanted);
+      if (length <= 0)
+        return -1;
+      append(std::span(buffer.data(), static_cast<size_t>(length)));
+      return static_cast<long>(static_cast<size_t>(length) / BYTES_PER_SAMPLE);
+    }
+
+    pollfd request{.fd = fd, .events = POLLIN, .revents = 0};
+    if (::poll(&request, 1, POLL_TIMEOUT_MS) <= 0)
+      return 0;
+
+    // Drain the pipe, only the newest samples end up in the window
+    long samples = 0;
+    for (int i = 0; i < MAX_READS_PER_DRAIN; ++i)
+    {
+      ssize_t length = ::read(fd, buffer.data() + buffered, buffer.size() - buffered);
+      if (length < 0 && errno == EINTR)
+        continue;
+      if (length < 0 && errno == EAGAIN)
+        break;
+      if (length <= 0)
+        return samples > 0 ? samples : -1;
+
+      size_t available = buffered + static_cast<size_t>(length);
+      append(std::span(buffer.data(), available));
+      samples += static_cast<long>(available / BYTES_PER_SAMPLE);
+
+      // Keep the first byte of a sample split between two reads
+      buffered = available % BYTES_PER_SAMPLE;
+      if (buffered)
+        buffer[0] = buffer[available - 1];
+    }
+    return samples;
+#else
+    return -1;
+#endif
+  }
+
+  void AudioCapture::append(std::span<const uint8_t> pcm)
+  {
+    // Older samples would be overwritten within the same call anyway
+    size_t count = std::min(pcm.size() / BYTES_PER_SAMPLE, history.size());
+    pcm = pcm.subspan(pcm.size() / BYTES_PER_SAMPLE * BYTES_PER_SAMPLE - count * BYTES_PER_SAMPLE, count * BYTES_PER_SAMPLE);
+
+    for (size_t i = 0; i < pcm.size(); i += BYTES_PER_SAMPLE)
+    {
+      auto sample = static_cast<int16_t>(pcm[i] | pcm[i + 1] << 8);
+      history[historyEnd] = sample / 32768.0f;
+      historyEnd = (historyEnd + 1) % history.size();
+    }
+  }
+} // namespace fw16led::managers
@@ -0,0 +1,262 @@
+#include "fw16led/managers/control.hpp"
+#include "fw16led/PresetRegistry.hpp"
+#include "fw16led/global.hpp"
+#include "fw16led/ledmatrix/framebuffer.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include "fw16led/managers/usb.hpp"
+#include <QFileInfo>
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace fw16led::managers
+{
+  auto parseOptions(const std::string& presetId, const QStringList& lines) -> std::optional<std::unordered_map<std::string, PresetOptionValue>>
+  {
+    const auto* descriptor = preset_registry->find(presetId);
+    std::unordered_map<std::string, PresetOptionValue> options;
+    for (const auto& line : lines)
+    {
+      auto separator = line.indexOf('=');
+      auto key = line.left(separator).toStdString();
+      auto value = separator < 0 ? QString() : line.mid(separator + 1);
+
+      auto index = descriptor ? descriptor->indexOf(key) : std::nullopt;
+      if (!index)
+        return std::nullopt;
+
+      switch (descriptor->options[*index].type)
+      {
+      case PresetOptionType::Checkbox:
+        options[key] = value == "1" || value == "true";
+        break;
+      case PresetOptionType::NumberRange:
+        options[key] = value.toDouble();
+        break;
+      case PresetOptionType::Text:
+        options[key] = value.toStdString();
+        break;
+      case PresetOptionType::Dropdown:
+        options[key] = value.toInt();
+        break;
+      }
+    }
+    return options;
+  }
+
+  ControlServer::ControlServer()
+  {
+    // Only the user running the daemon may drive the panels
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    QObject::connect(&server, &QLocalServer::newConnection, &server, [this]()
+                     { accept(); });
+  }
+
+  ControlServer::~ControlServer()
+  {
+    server.close();
+  }
+
+  auto ControlServer::listen(const QString& name) -> bool
+  {
+    QLocalServer::removeServer(name);
+    if (!server.listen(name))
+    {
+      LOG_ERROR("Could not listen on control socket {}: {}", name.toStdString(), server.errorString().toStdString());
+      return false;
+    }
+
+    sharedFramesPrefix = "/" + QFileInfo(name).fileName().toStdString();
+    LOG_INFO("Listening for control connections on {}", server.fullServerName().toStdString());
+    return true;
+  }
+
+  void ControlServer::accept()
+  {
+    while (QLocalSocket* socket = server.nextPendingConnection())
+    {
+      LOG_DEBUG("Control client connected");
+      buffers[socket];
+      QObject::connect(socket, &QLocalSocket::readyRead, socket, [this, socket]()
+                       { receive(socket); });
+      QObject::connect(socket, &QLocalSocket::disconnected, socket, [this, socket]()
+                       {
+                         LOG_DEBUG("Control client disconnected");
+                         buffers.erase(socket);
+                         socket->deleteLater(); });
+    }
+  }
+
+  void ControlServer::receive(QLocalSocket* socket)
+  {
+    auto& buffer = buffers[socket];
+    buffer.append(socket->readAll());
+
+    // A streaming producer may have sent several messages since the last read
+    qsizetype offset = 0;
+    while (buffer.size() - offset >= static_cast<qsizetype>(CONTROL_HEADER_SIZE))
+    {
+      const auto* header = reinterpret_cast<const uint8_t*>(buffer.constData() + offset);
+      qsizetype length = header[2] | (header[3] << 8);
+      if (buffer.size() - offset < static_cast<qsizetype>(CONTROL_HEADER_SIZE) + length)
+        break;
+
+      QByteArrayView payload(buffer.constData() + offset + CONTROL_HEADER_SIZE, length);
+      handle(socket, static_cast<ControlMessage>(header[0]), header[1], payload);
+      offset += CONTROL_HEADER_SIZE + length;
+    }
+    buffer.remove(0, offset);
+  }
+
+  void ControlServer::handle(QLocalSocket* socket, ControlMessage type, uint8_t panelId, QByteArrayView payload)
+  {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(payload.data());
+    bool found = true;
+
+    switch (type)
+    {
+    case ControlMessage::Frame:
+    {
+      if (payload.size() != ledmatrix::FRAME_SIZE)
+      {
+        reject(socket, panelId, QString("A frame has to be %1 bytes").arg(ledmatrix::FRAME_SIZE));
+        return;
+      }
+
+      ledmatrix::Frame frame;
+      std::copy(bytes, bytes + ledmatrix::FRAME_SIZE, frame.begin());
+      found = usb_manager->withPanels(panelId, [&frame](LedPanel& panel)
+                                      { panel.showFrame(frame); });
+      break;
+    }
+    case ControlMessage::GreyFrame:
+    {
+      if (payload.size() != ledmatrix::PIXELS)
+      {
+        reject(socket, panelId, QString("A greyscale frame has to be %1 bytes").arg(ledmatrix::PIXELS));
+        return;
+      }
+
+      ledmatrix::Framebuffer frame;
+      for (int x = 0; x < ledmatrix::WIDTH; ++x)
+      {
+        for (int y = 0; y < ledmatrix::HEIGHT; ++y)
+          frame.at(x, y) = bytes[x * ledmatrix::HEIGHT + y];
+      }
+      found = usb_manager->withPanels(panelId, [&frame](LedPanel& panel)
+                                      { panel.showGreyFrame(frame); });
+      break;
+    }
+    case ControlMessage::Preset:
+    {
+      auto lines = QString::fromUtf8(payload).split('\n', Qt::SkipEmptyParts);
+      auto presetId = lines.isEmpty() ? std::string() : lines.takeFirst().toStdString();
+
+      if (!preset_registry->find(presetId))
+      {
+        reject(socket, panelId, QString("Unknown preset '%1'").arg(QString::fromStdString(presetId)));
+        return;
+      }
+
+      auto options = parseOptions(presetId, lines);
+      if (!options)
+      {
+        reject(socket, panelId, QString("Unknown option for preset '%1'").arg(QString::fromStdString(presetId)));
+        return;
+      }
+
+      found = usb_manager->withPanels(panelId, [&](LedPanel& panel)
+                                      { panel.applyPreset(presetId, *options); });
+      break;
+    }
+    case ControlMessage::Release:
+      if (panelId == ALL_PANELS)
+      {
+        usb_manager->stopSpan();
+        break;
+      }
+      found = usb_manager->withPanels(panelId, [](LedPanel& panel)
+                                      { panel.applyConfig(); });
+      break;
+    case ControlMessage::Brightness:
+    {
+      if (payload.size() != 1)
+      {
+        reject(socket, panelId, "Brightness has to be a single byte");
+        return;
+      }
+
+      found = usb_manager->withPanels(panelId, [brightness = bytes[0]](LedPanel& panel)
+                                      { panel.setBrightness(brightness); });
+      break;
+    }
+    case ControlMessage::ListPanels:
+    {
+      QByteArray ids;
+      for (const auto& panel : usb_manager->get_ledpanels())
+        ids.append(static_cast<char>(panel->getId()));
+      send(socket, ControlMessage::ListPanels, ALL_PANELS, ids);
+      break;
+    }
+    case ControlMessage::Canvas:
+    {
+      auto panels = static_cast<int>(usb_manager->get_ledpanels().size());
+      if (panels == 0 || payload.size() != static_cast<qsizetype>(panels) * ledmatrix::PIXELS)
+      {
+        reject(socket, panelId, QString("A canvas has to be %1 bytes for %2 panels").arg(panels * ledmatrix::PIXELS).arg(panels));
+        return;
+      }
+
+      // Column by column from the top left, so each panel's part is contiguous just like in the canvas
+      if (canvas.panel_count() != panels)
+        canvas = ledmatrix::Canvas(panels);
+      for (int x = 0; x < canvas.width(); ++x)
+      {
+        for (int y = 0; y < ledmatrix::HEIGHT; ++y)
+          canvas.at(x, y) = bytes[x * ledmatrix::HEIGHT + y];
+      }
+      usb_manager->showCanvas(canvas);
+      break;
+    }
+    case ControlMessage::SharedFrames:
+    {
+      if (panelId == ALL_PANELS)
+      {
+        reject(socket, panelId, "Shared frames need a single panel");
+        return;
+      }
+
+      auto name = usb_manager->mapSharedFrames(panelId, sharedFramesPrefix);
+      if (name.empty())
+      {
+        reject(socket, panelId, QString("Could not share frames of panel %1").arg(panelId));
+        return;
+      }
+
+      send(socket, ControlMessage::SharedFrames, panelId, QByteArray::fromStdString(name));
+      break;
+    }
+    default:
+      reject(socket, panelId, QString("Unknown message type %1").arg(static_cast<int>(type)));
+      return;
+    }
+
+    if (!found)
+      reject(socket, panelId, QString("No panel with id %1").arg(panelId));
+  }
+
+  void ControlServer::send(QLocalSocket* socket, ControlMessage type, uint8_t panelId, QByteArrayView payload)
+  {
+    auto length = static_cast<uint16_t>(std::min<qsizetype>(payload.size(), UINT16_MAX));
+    const char header[CONTROL_HEADER_SIZE] = {static_cast<char>(type), static_cast<char>(panelId), static_cast<char>(length & 0xFF), static_cast<char>(length >> 8)};
+    socket->write(header, CONTROL_HEADER_SIZE);
+    socket->write(payload.data(), length);
+  }
+
+  void ControlServer::reject(QLocalSocket* socket, uint8_t panelId, const QString& reason)
+  {
+    LOG_DEBUG("Rejecting control message: {}", reason.toStdString());
+    send(socket, ControlMessage::Error, panelId, reason.toUtf8());
+  }
+} // namespace fw16led::managers
@@ -0,0 +1,110 @@
+#include "fw16led/managers/identity.hpp"
+#include "fw16led/global.hpp"
+#include "fw16led/managers/usb.hpp"
+#include <algorithm>
+#include <array>
+#include <string>
+
+namespace fw16led::managers
+{
+  inline constexpr auto SETTINGS_GROUP = "panel_ids";
+  inline constexpr int MAX_PORT_DEPTH = 7;
+  inline constexpr int FIRST_ID = 1;
+  inline constexpr int LAST_ID = ALL_PANELS - 1; /**< ALL_PANELS addresses every panel, so no panel may have it. */
+
+  PanelIdentityStore::PanelIdentityStore()
+  {
+    settings->beginGroup(SETTINGS_GROUP);
+    for (const auto& key : settings->childKeys())
+    {
+      int id = settings->value(key).toInt();
+      if (id < FIRST_ID || id > LAST_ID)
+      {
+        LOG_WARN("Ignoring invalid id {} of panel at {}", id, key.toStdString());
+        continue;
+      }
+      ids[key.toStdString()] = static_cast<uint8_t>(id);
+    }
+    settings->endGroup();
+
+    LOG_DEBUG("Loaded {} known panel locations", ids.size());
+  }
+
+  auto PanelIdentityStore::idFor(const std::string& location, std::span<const uint8_t> attached) -> std::optional<uint8_t>
+  {
+    if (auto it = ids.find(location); it != ids.end())
+    {
+      return it->second;
+    }
+
+    // Hand out the lowest id no other location uses yet
+    std::optional<uint8_t> id;
+    for (int candidate = FIRST_ID; candidate <= LAST_ID && !id; ++candidate)
+    {
+      if (!isKnown(static_cast<uint8_t>(candidate)))
+        id = static_cast<uint8_t>(candidate);
+    }
+
+    // Every id was handed out once, take one over from a location that is not plugged in
+    if (!id)
+    {
+      auto reclaimable = ids.end();
+      for (auto it = ids.begin(); it != ids.end(); ++it)
+      {
+        if (std::ranges::find(attached, it->second) == attached.end() && (reclaimable == ids.end() || it->second < reclaimable->second))
+          reclaimable = it;
+      }
+      if (reclaimable == ids.end())
+      {
+        LOG_ERROR("No id left for panel at {}, all {} ids belong to connected panels", location, LAST_ID);
+        return std::nullopt;
+      }
+
+      LOG_WARN("All ids are taken, moving id {} from the panel at {} to the one at {}", reclaimable->second, reclaimable->first, location);
+      id = reclaimable->second;
+      settings->remove(QString("%1/%2").arg(SETTINGS_GROUP).arg(QString::fromStdString(reclaimable->first)));
+      ids.erase(reclaimable);
+    }
+
+    LOG_INFO("Assigning id {} to panel at {}", *id, location);
+    ids[location] = *id;
+    settings->setValue(QString("%1/%2").arg(SETTINGS_GROUP).arg(QString::fromStdString(location)), *id);
+    return id;
+  }
+
+  auto PanelIdentityStore::isKnown(uint8_t id) const -> bool
+  {
+    return std::any_of(ids.begin(), ids.end(), [id](const auto& entry)
+                       { return entry.second == id; });
+  }
+
+  auto PanelIdentityStore::locationOf(libusb_device* device, libusb_device_handle* handle) -> std::string
+  {
+    std::array<uint8_t, MAX_PORT_DEPTH> ports{};
+    int depth = libusb_get_port_numbers(device, ports.data(), static_cast<int>(ports.size()));
+    if (depth > 0)
+    {
+      std::string location = std::to_string(libusb_get_bus_number(device)) + "-" + std::to_string(ports[0]);
+      for (int i = 1; i < depth; i++)
+      {
+        location += "." + std::to_string(ports[i]);
+      }
+      return location;
+    }
+
+    libusb_device_descriptor desc;
+    if (libusb_get_device_descriptor(device, &desc) == 0 && desc.iSerialNumber != 0)
+    {
+      std::array<unsigned char, 128> serial{};
+      int length = libusb_get_string_descriptor_ascii(handle, desc.iSerialNumber, serial.data(), static_cast<int>(serial.size()));
+      if (length > 0)
+      {
+        return "serial-" + std::string(reinterpret_cast<const char*>(serial.data()), length);
+      }
+    }
+
+    // Not stable across reboots, but still better than enumeration order
+    LOG_WARN("Could not determine a stable location for the panel");
+    return std::to_string(libusb_get_bus_number(device)) + "-addr" + std::to_string(libusb_get_device_address(device));
+  }
+} // namespace fw16led::managers
@@ -0,0 +1,227 @@
+#include "fw16led/managers/imageimport.hpp"
+#include "fw16led/global.hpp"
+#include "fw16led/ledmatrix/bitmap.hpp"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QSize>
+#include <QStandardPaths>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Part of every cache key, has to change whenever the same options convert differently.
+   */
+  inline constexpr int CONVERTER_VERSION = 1;
+
+  /**
+   * @brief Images are decoded at most this many times the panel size, the rest of the detail would be averaged away anyway.
+   */
+  inline constexpr int DECODE_SCALE = 8;
+
+  inline constexpr int MAX_FRAMES = 10000;
+  inline constexpr auto STILL_DURATION = std::chrono::milliseconds(1000);
+
+  namespace
+  {
+    using Light = std::array<float, ledmatrix::PIXELS>; /**< Linear light from 0 to 1, column by column like Framebuffer. */
+
+    auto cache_directory() -> QString
+    {
+      return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/framework16-led-matrix-manager/animations";
+    }
+
+    /**
+     * @brief Hash of the file's content and everything else that changes the result.
+     */
+    auto cache_key(const QString& path, const ImageImportOptions& options) -> std::optional<QString>
+    {
+      QFile file(path);
+      if (!file.open(QIODevice::ReadOnly))
+      {
+        LOG_WARN("Cannot open image {}: {}", path.toStdString(), file.errorString().toStdString());
+        return std::nullopt;
+      }
+
+      QCryptographicHash hash(QCryptographicHash::Sha256);
+      hash.addData(&file);
+      hash.addData(QString("%1 %2 %3 %4").arg(CONVERTER_VERSION).arg(static_cast<int>(options.format)).arg(options.dither ? 1 : 0).arg(options.gamma).toUtf8());
+      return QString::fromLatin1(hash.result().toHex());
+    }
+
+    /**
+     * @brief Average an image down to the panel in linear light, keeping its aspect ratio and centring it on black.
+     */
+    void to_light(const QImage& frame, const std::array<float, 256>& linear, Light& light)
+    {
+      QImage image = frame.convertToFormat(QImage::Format_ARGB32);
+      int width = image.width();
+      int height = image.height();
+      double scale = std::min(static_cast<double>(ledmatrix::WIDTH) / width, static_cast<double>(ledmatrix::HEIGHT) / height);
+      int targetWidth = std::clamp(static_cast<int>(std::lround(width * scale)), 1, ledmatrix::WIDTH);
+      int targetHeight = std::clamp(static_cast<int>(std::lround(height * scale)), 1, ledmatrix::HEIGHT);
+      int left = (ledmatrix::WIDTH - targetWidth) / 2;
+      int top = (ledmatrix::HEIGHT - targetHeight) / 2;
+
+      std::vector<float> values(static_cast<size_t>(width) * height);
+      for (int y = 0; y < height; ++y)
+      {
+        const auto* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x)
+        {
+          QRgb pixel = line[x];
+          float value = 0.2126f * linear[qRed(pixel)] + 0.7152f * linear[qGreen(pixel)] + 0.0722f * linear[qBlue(pixel)];
+          values[static_cast<size_t>(y) * width + x] = value * qAlpha(pixel) / 255.0f;
+        }
+      }
+
+      // Each panel pixel averages the source pixels it covers, at least one when the image is smaller than the panel
+      light.fill(0.0f);
+      for (int tx = 0; tx < targetWidth; ++tx)
+      {
+        int x0 = tx * width / targetWidth;
+        int x1 = std::max(x0 + 1, (tx + 1) * width / targetWidth);
+        for (int ty = 0; ty < targetHeight; ++ty)
+        {
+          int y0 = ty * height / targetHeight;
+          int y1 = std::max(y0 + 1, (ty + 1) * height / targetHeight);
+          float sum = 0.0f;
+          for (int y = y0; y < y1; ++y)
+          {
+            for (int x = x0; x < x1; ++x)
+              sum += values[static_cast<size_t>(y) * width + x];
+          }
+          light[(left + tx) * ledmatrix::HEIGHT + top + ty] = sum / ((x1 - x0) * (y1 - y0));
+        }
+      }
+    }
+
+    auto to_framebuffer(const Light& light) -> ledmatrix::Framebuffer
+    {
+      ledmatrix::Framebuffer framebuffer;
+      for (int x = 0; x < ledmatrix::WIDTH; ++x)
+      {
+        for (int y = 0; y < ledmatrix::HEIGHT; ++y)
+          framebuffer.at(x, y) = static_cast<uint8_t>(std::lround(std::clamp(light[x * ledmatrix::HEIGHT + y], 0.0f, 1.0f) * 255));
+      }
+      return framebuffer;
+    }
+
+    /**
+     * @brief Turn light into lit and dark pixels, diffusing the error so that the average light is kept.
+     */
+    auto to_bitmap(Light light, bool dither) -> ledmatrix::MatrixBitmap
+    {
+      ledmatrix::MatrixBitmap bitmap;
+      auto at = [&light](int x, int y) -> float&
+      { return light[x * ledmatrix::HEIGHT + y]; };
+
+      for (int y = 0; y < ledmatrix::HEIGHT; ++y)
+      {
+        for (int x = 0; x < ledmatrix::WIDTH; ++x)
+        {
+          bool on = at(x, y) >= 0.5f;
+          bitmap.set(x, y, on);
+          if (!dither)
+            continue;
+
+          float error = at(x, y) - (on ? 1.0f : 0.0f);
+          if (x + 1 < ledmatrix::WIDTH)
+            at(x + 1, y) += error * 7 / 16;
+          if (y + 1 < ledmatrix::HEIGHT)
+          {
+            if (x > 0)
+              at(x - 1, y + 1) += error * 3 / 16;
+            at(x, y + 1) += error * 5 / 16;
+            if (x + 1 < ledmatrix::WIDTH)
+              at(x + 1, y + 1) += error / 16;
+          }
+        }
+      }
+      return bitmap;
+    }
+  } // namespace
+
+  auto importImage(const QString& path, const ImageImportOptions& options, const std::atomic<bool>& cancelled) -> std::optional<QString>
+  {
+    auto key = cache_key(path, options);
+    if (!key)
+      return std::nullopt;
+
+    QString directory = cache_directory();
+    QString cached = QDir(directory).filePath(*key + ".fwan");
+    if (QFile::exists(cached))
+    {
+      LOG_DEBUG("Using cached conversion {} of {}", cached.toStdString(), path.toStdString());
+      return cached;
+    }
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+
+    // Formats like JPEG decode straight to a smaller size, for the others the reader scales each frame
+    QSize size = reader.size();
+    QSize bound(ledmatrix::WIDTH * DECODE_SCALE, ledmatrix::HEIGHT * DECODE_SCALE);
+    if (size.isValid() && (size.width() > bound.width() || size.height() > bound.height()))
+    {
+      QSize scaled = size.scaled(bound, Qt::KeepAspectRatio);
+      reader.setScaledSize(QSize(std::max(scaled.width(), 1), std::max(scaled.height(), 1)));
+    }
+
+    std::array<float, 256> linear;
+    for (int i = 0; i < 256; ++i)
+      linear[i] = static_cast<float>(std::pow(i / 255.0, options.gamma));
+
+    ledmatrix::AnimationWriter writer(options.format);
+    Light light;
+    int frames = 0;
+    while (frames < MAX_FRAMES && reader.canRead())
+    {
+      if (cancelled)
+        return std::nullopt;
+
+      QImage frame = reader.read();
+      if (frame.isNull())
+        break;
+      auto duration = reader.nextImageDelay() > 0 ? std::chrono::milliseconds(reader.nextImageDelay()) : STILL_DURATION;
+
+      to_light(frame, linear, light);
+      if (options.format == ledmatrix::AnimationFormat::Grey)
+        writer.add(to_framebuffer(light), duration);
+      else
+        writer.add(to_bitmap(light, options.dither).data(), duration);
+      frames++;
+    }
+
+    if (frames == 0)
+    {
+      LOG_WARN("Cannot read image {}: {}", path.toStdString(), reader.errorString().toStdString());
+      return std::nullopt;
+    }
+
+    auto animation = writer.finish();
+    QDir().mkpath(directory);
+    QSaveFile file(cached);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+      LOG_WARN("Could not open cache file {}: {}", cached.toStdString(), file.errorString().toStdString());
+      return std::nullopt;
+    }
+    file.write(reinterpret_cast<const char*>(animation.data()), static_cast<qint64>(animation.size()));
+    if (!file.commit())
+    {
+      LOG_WARN("Could not write cache file {}: {}", cached.toStdString(), file.errorString().toStdString());
+      return std::nullopt;
+    }
+
+    LOG_INFO("Converted {} frames of {} into {}", frames, path.toStdString(), cached.toStdString());
+    return cached;
+  }
+} // namespace fw16led::managers
@@ -0,0 +1,113 @@
+#include "fw16led/managers/metrics.hpp"
+#include "fw16led/global.hpp"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <array>
+#include <utility>
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Fractions reported for the latency histogram.
+   */
+  inline constexpr std::array<std::pair<const char*, double>, 3> LATENCY_PERCENTILES = {{{"p50_us", 0.5}, {"p90_us", 0.9}, {"p99_us", 0.99}}};
+
+  namespace
+  {
+    /**
+     * @brief Count, percentiles and non-empty buckets of a histogram.
+     */
+    auto histogramToJson(const ledmatrix::LatencyHistogram& histogram) -> QJsonObject
+    {
+      QJsonObject json;
+      json["count"] = static_cast<double>(histogram.count());
+      for (const auto& [name, fraction] : LATENCY_PERCENTILES)
+        json[name] = static_cast<double>(histogram.percentile(fraction).count());
+
+      // Only non-empty buckets, each with its exclusive upper limit
+      QJsonArray buckets;
+      const auto& counts = histogram.get_buckets();
+      for (size_t i = 0; i < counts.size(); ++i)
+      {
+        if (counts[i] == 0)
+          continue;
+        QJsonObject bucket;
+        bucket["lt_us"] = static_cast<double>(ledmatrix::LatencyHistogram::bucket_limit(i).count());
+        bucket["count"] = static_cast<double>(counts[i]);
+        buckets.append(bucket);
+      }
+      json["buckets"] = buckets;
+      return json;
+    }
+  } // namespace
+
+  auto panelMetricsToJson(const LedPanel& panel) -> QJsonObject
+  {
+    auto matrix = panel.getLedMatrix();
+    auto metrics = matrix->get_metrics();
+    const auto& transport = metrics.transport;
+
+    // Counters are written as doubles, which is exact far beyond anything a panel will ever send
+    QJsonObject commands;
+    for (size_t i = 0; i < ledmatrix::COMMAND_COUNT; ++i)
+    {
+      if (transport.commandsSent[i] > 0)
+        commands[ledmatrix::command_name(static_cast<ledmatrix::Command>(i))] = static_cast<double>(transport.commandsSent[i]);
+    }
+
+    QJsonObject json;
+    json["id"] = panel.getId();
+    json["connected"] = matrix->is_connected();
+    json["packets_sent"] = static_cast<double>(transport.packetsSent);
+    json["bytes_sent"] = static_cast<double>(transport.bytesSent);
+    json["retries"] = static_cast<double>(transport.retries);
+    json["timeouts"] = static_cast<double>(transport.timeouts);
+    json["failures"] = static_cast<double>(transport.failures);
+    json["frames_sent"] = static_cast<double>(metrics.frames.sent);
+    json["frames_elided"] = static_cast<double>(metrics.frames.elided);
+    json["commands"] = commands;
+    json["latency"] = histogramToJson(transport.latency);
+    return json;
+  }
+
+  auto spanStatsToJson(const SpanStats& stats) -> QJsonObject
+  {
+    QJsonObject json;
+    json["commits"] = static_cast<double>(stats.commits);
+    json["skew"] = histogramToJson(stats.skew);
+    return json;
+  }
+
+  auto metricsToJson(const std::vector<std::shared_ptr<LedPanel>>& panels, const SpanStats& span) -> QJsonObject
+  {
+    QJsonArray entries;
+    for (const auto& panel : panels)
+      entries.append(panelMetricsToJson(*panel));
+
+    QJsonObject json;
+    json["time"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs);
+    json["panels"] = entries;
+    json["span"] = spanStatsToJson(span);
+    return json;
+  }
+
+  auto writeMetrics(const QString& path, const std::vector<std::shared_ptr<LedPanel>>& panels, const SpanStats& span) -> bool
+  {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+      LOG_WARN("Could not open metrics file {}: {}", path.toStdString(), file.errorString().toStdString());
+      return false;
+    }
+
+    file.write(QJsonDocument(metricsToJson(panels, span)).toJson());
+    if (!file.commit())
+    {
+      LOG_WARN("Could not write metrics file {}: {}", path.toStdString(), file.errorString().toStdString());
+      return false;
+    }
+    return true;
+  }
+} // namespace fw16led::managers
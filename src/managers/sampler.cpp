@@ -0,0 +1,394 @@
+#include "fw16led/managers/sampler.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fw16led::managers
+{
+  inline constexpr size_t SECTOR_SIZE = 512;
+
+  /**
+   * @brief Only the first line of /proc/stat is needed, the rest can be many kilobytes of interrupt counters.
+   */
+  inline constexpr size_t STAT_READ_SIZE = 4096;
+  inline constexpr size_t MEMINFO_READ_SIZE = 1024;
+  inline constexpr size_t NETDEV_READ_SIZE = 16384;
+  inline constexpr size_t DISKSTATS_READ_SIZE = 32768;
+  inline constexpr size_t SYSFS_READ_SIZE = 32;
+
+  /**
+   * @brief hwmon drivers reporting the CPU temperature, the first one found is used.
+   */
+  inline constexpr std::array<std::string_view, 5> CPU_SENSORS = {"k10temp", "coretemp", "zenpower", "cpu_thermal", "acpitz"};
+
+  namespace
+  {
+    /**
+     * @brief Splits text into lines and fields in place, without copying or allocating.
+     */
+    class FieldReader
+    {
+    public:
+      explicit FieldReader(std::string_view text)
+        : rest(text)
+      {
+      }
+
+      /**
+       * @brief Move to the next complete line, a line cut off by the end of the buffer is skipped.
+       */
+      auto next_line() -> bool
+      {
+        auto end = rest.find('\n');
+        if (end == std::string_view::npos)
+          return false;
+        line = rest.substr(0, end);
+        rest.remove_prefix(end + 1);
+        return true;
+      }
+
+      /**
+       * @brief Next field of the current line, separated by spaces or the given extra separator.
+       */
+      auto word(char separator = ' ') -> std::string_view
+      {
+        auto isSeparator = [separator](char c)
+        { return c == ' ' || c == '\t' || c == separator; };
+        while (!line.empty() && isSeparator(line.front()))
+          line.remove_prefix(1);
+        size_t length = 0;
+        while (length < line.size() && !isSeparator(line[length]))
+          length++;
+        auto field = line.substr(0, length);
+        line.remove_prefix(length);
+        return field;
+      }
+
+      auto number() -> uint64_t
+      {
+        auto field = word();
+        uint64_t value = 0;
+        std::from_chars(field.data(), field.data() + field.size(), value);
+        return value;
+      }
+
+      /**
+       * @brief Skip fields of the current line.
+       */
+      void skip(int count)
+      {
+        for (int i = 0; i < count; ++i)
+          word();
+      }
+
+    private:
+      std::string_view rest;
+      std::string_view line;
+    };
+
+    auto parse_number(std::string_view text) -> std::optional<int64_t>
+    {
+      int64_t value = 0;
+      auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+      if (result.ec != std::errc())
+        return std::nullopt;
+      return value;
+    }
+
+    /**
+     * @brief Whether a /proc/diskstats entry is a whole disk, not a partition or a virtual device.
+     */
+    auto is_whole_disk(std::string_view name) -> bool
+    {
+      for (std::string_view ignored : {"loop", "ram", "zram", "dm-", "md", "sr"})
+      {
+        if (name.starts_with(ignored))
+          return false;
+      }
+
+      // nvme0n1p2 and mmcblk0p1 are partitions of nvme0n1 and mmcblk0
+      if (name.starts_with("nvme") || name.starts_with("mmcblk"))
+      {
+        auto p = name.find_last_of('p');
+        return p == std::string_view::npos || p + 1 == name.size() || !std::isdigit(static_cast<unsigned char>(name[p + 1])) || name.find_first_not_of("0123456789", p + 1) != std::string_view::npos;
+      }
+
+      // sda1 is a partition of sda
+      return !std::isdigit(static_cast<unsigned char>(name.back()));
+    }
+
+    /**
+     * @brief Read a small text file, used while looking for sensors only.
+     */
+    auto read_line(const std::filesystem::path& path) -> std::string
+    {
+      std::ifstream file(path);
+      std::string line;
+      std::getline(file, line);
+      return line;
+    }
+
+    auto find_cpu_sensor() -> std::string
+    {
+      std::error_code error;
+      std::string best;
+      size_t bestRank = CPU_SENSORS.size();
+      for (const auto& entry : std::filesystem::directory_iterator("/sys/class/hwmon", error))
+      {
+        auto name = read_line(entry.path() / "name");
+        auto rank = static_cast<size_t>(std::ranges::find(CPU_SENSORS, name) - CPU_SENSORS.begin());
+        if (rank < bestRank && std::filesystem::exists(entry.path() / "temp1_input", error))
+        {
+          best = (entry.path() / "temp1_input").string();
+          bestRank = rank;
+        }
+      }
+      return best;
+    }
+
+    auto find_battery() -> std::string
+    {
+      std::error_code error;
+      for (const auto& entry : std::filesystem::directory_iterator("/sys/class/power_supply", error))
+      {
+        if (read_line(entry.path() / "type") == "Battery" && std::filesystem::exists(entry.path() / "capacity", error))
+          return (entry.path() / "capacity").string();
+      }
+      return {};
+    }
+  } // namespace
+
+  auto SystemSampler::Source::read() -> std::string_view
+  {
+#ifdef __linux__
+    if (fd < 0)
+      return {};
+    ssize_t length = ::pread(fd, buffer.data(), buffer.size(), 0);
+    if (length <= 0)
+      return {};
+    return std::string_view(buffer.data(), static_cast<size_t>(length));
+#else
+    return {};
+#endif
+  }
+
+  auto SystemSampler::open(const char* path, size_t size) -> Source
+  {
+    Source source;
+#ifdef __linux__
+    if (*path)
+      source.fd = ::open(path, O_RDONLY | O_CLOEXEC);
+#endif
+    if (source.fd < 0)
+    {
+      LOG_DEBUG("Not sampling {}, it could not be opened", *path ? path : "missing sensor");
+      return source;
+    }
+    source.buffer.resize(size);
+    return source;
+  }
+
+  SystemSampler::SystemSampler() = default;
+
+  void SystemSampler::discover()
+  {
+    discovered = true;
+    stat = open("/proc/stat", STAT_READ_SIZE);
+    meminfo = open("/proc/meminfo", MEMINFO_READ_SIZE);
+    netdev = open("/proc/net/dev", NETDEV_READ_SIZE);
+    diskstats = open("/proc/diskstats", DISKSTATS_READ_SIZE);
+    temperature = open(find_cpu_sensor().c_str(), SYSFS_READ_SIZE);
+    battery = open(find_battery().c_str(), SYSFS_READ_SIZE);
+  }
+
+  SystemSampler::~SystemSampler()
+  {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    wakeup.notify_one();
+    if (thread.joinable())
+      thread.join();
+
+#ifdef __linux__
+    for (Source* source : {&stat, &meminfo, &netdev, &diskstats, &temperature, &battery})
+    {
+      if (source->fd >= 0)
+        ::close(source->fd);
+    }
+#endif
+  }
+
+  void SystemSampler::subscribe()
+  {
+    {
+      std::lock_guard lock(mutex);
+      subscribers++;
+      if (!thread.joinable())
+        thread = std::thread(&SystemSampler::run, this);
+    }
+    wakeup.notify_one();
+  }
+
+  void SystemSampler::unsubscribe()
+  {
+    {
+      std::lock_guard lock(mutex);
+      subscribers--;
+    }
+    wakeup.notify_one();
+  }
+
+  auto SystemSampler::get_snapshot() -> SystemSnapshot
+  {
+    std::lock_guard lock(mutex);
+    return snapshot;
+  }
+
+  void SystemSampler::run()
+  {
+    std::unique_lock lock(mutex);
+    while (!stopping)
+    {
+      if (subscribers == 0)
+      {
+        LOG_DEBUG("Stopped sampling system load");
+        wakeup.wait(lock, [this]()
+                    { return stopping || subscribers > 0; });
+
+        // Rates over the idle time would be meaningless
+        previous.valid = false;
+        continue;
+      }
+
+      LOG_DEBUG("Started sampling system load");
+      while (!stopping && subscribers > 0)
+      {
+        lock.unlock();
+        sample();
+        lock.lock();
+        wakeup.wait_for(lock, SAMPLE_INTERVAL, [this]()
+                        { return stopping || subscribers == 0; });
+      }
+    }
+  }
+
+  void SystemSampler::sample()
+  {
+    // Deferred to the first sample, so a sampler nobody subscribes to never touches /proc or /sys
+    if (!discovered)
+      discover();
+
+    SystemSnapshot next;
+    Counters counters;
+    counters.time = std::chrono::steady_clock::now();
+    next.time = counters.time;
+
+    // cpu  user nice system idle iowait irq softirq steal ...
+    FieldReader cpu(stat.read());
+    bool hasCpu = cpu.next_line() && cpu.word() == "cpu";
+    if (hasCpu)
+    {
+      std::array<uint64_t, 8> times{};
+      for (auto& time : times)
+        time = cpu.number();
+      for (auto time : times)
+        counters.cpuTotal += time;
+      counters.cpuBusy = counters.cpuTotal - times[3] - times[4];
+    }
+
+    // MemTotal:  16000000 kB, with MemAvailable a few lines below
+    FieldReader memory(meminfo.read());
+    uint64_t memoryTotal = 0;
+    uint64_t memoryAvailable = 0;
+    while (memory.next_line())
+    {
+      auto key = memory.word();
+      if (key == "MemTotal:")
+        memoryTotal = memory.number();
+      else if (key == "MemAvailable:")
+        memoryAvailable = memory.number();
+    }
+    if (memoryTotal > 0)
+      next.memory = 1.0 - static_cast<double>(std::min(memoryAvailable, memoryTotal)) / memoryTotal;
+
+    // Two header lines, then "  eth0: rxbytes rxpackets errs drop fifo frame compressed multicast txbytes ..."
+    FieldReader network(netdev.read());
+    bool hasNetwork = network.next_line() && network.next_line();
+    while (hasNetwork && network.next_line())
+    {
+      auto name = network.word(':');
+      if (name == "lo")
+        continue;
+      counters.networkReceive += network.number();
+      network.skip(7);
+      counters.networkTransmit += network.number();
+    }
+
+    // major minor name reads merged sectors_read ms writes merged sectors_written ...
+    FieldReader disks(diskstats.read());
+    bool hasDisks = false;
+    while (disks.next_line())
+    {
+      disks.skip(2);
+      auto name = disks.word();
+      if (name.empty() || !is_whole_disk(name))
+        continue;
+      hasDisks = true;
+      disks.skip(2);
+      counters.diskRead += disks.number() * SECTOR_SIZE;
+      disks.skip(3);
+      counters.diskWrite += disks.number() * SECTOR_SIZE;
+    }
+
+    // Sysfs attributes hold a single number followed by a newline
+    FieldReader sensor(temperature.read());
+    if (sensor.next_line())
+    {
+      if (auto millidegrees = parse_number(sensor.word()))
+        next.temperature = *millidegrees / 1000.0;
+    }
+    FieldReader charge(battery.read());
+    if (charge.next_line())
+    {
+      if (auto percent = parse_number(charge.word()))
+        next.battery = std::clamp(*percent / 100.0, 0.0, 1.0);
+    }
+
+    // Everything cumulative needs a previous sample to turn into a rate
+    if (previous.valid)
+    {
+      double seconds = std::chrono::duration<double>(counters.time - previous.time).count();
+      auto rate = [seconds](uint64_t now, uint64_t before)
+      { return now >= before && seconds > 0 ? (now - before) / seconds : 0.0; };
+
+      if (hasCpu && counters.cpuTotal > previous.cpuTotal)
+        next.cpu = static_cast<double>(counters.cpuBusy - std::min(previous.cpuBusy, counters.cpuBusy)) / (counters.cpuTotal - previous.cpuTotal);
+      if (hasNetwork)
+      {
+        next.networkReceive = rate(counters.networkReceive, previous.networkReceive);
+        next.networkTransmit = rate(counters.networkTransmit, previous.networkTransmit);
+      }
+      if (hasDisks)
+      {
+        next.diskRead = rate(counters.diskRead, previous.diskRead);
+        next.diskWrite = rate(counters.diskWrite, previous.diskWrite);
+      }
+    }
+    counters.valid = true;
+    previous = counters;
+
+    std::lock_guard lock(mutex);
+    next.sequence = snapshot.sequence + 1;
+    snapshot = next;
+  }
+} // namespace fw16led::managers
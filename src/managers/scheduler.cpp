@@ -0,0 +1,99 @@
+#include "fw16led/managers/scheduler.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+namespace fw16led::managers
+{
+  FrameScheduler::FrameScheduler()
+    : thread(&FrameScheduler::run, this)
+  {
+  }
+
+  FrameScheduler::~FrameScheduler()
+  {
+    LOG_DEBUG("Stopping render thread");
+    {
+      std::lock_guard lock(mutex);
+      running = false;
+    }
+    wakeup.notify_one();
+    thread.join();
+  }
+
+  void FrameScheduler::add(std::shared_ptr<LedPanel> panel)
+  {
+    {
+      std::lock_guard lock(mutex);
+      panels.push_back(std::move(panel));
+      woken = true;
+    }
+    wakeup.notify_one();
+  }
+
+  void FrameScheduler::remove(const std::shared_ptr<LedPanel>& panel)
+  {
+    std::unique_lock lock(mutex);
+    std::erase(panels, panel);
+
+    // The tick holds its own reference, which must not be the one that destroys the panel
+    tickDone.wait(lock, [this, &panel]()
+                  { return std::find(ticking.begin(), ticking.end(), panel) == ticking.end(); });
+  }
+
+  void FrameScheduler::wake()
+  {
+    {
+      std::lock_guard lock(mutex);
+      woken = true;
+    }
+    wakeup.notify_one();
+  }
+
+  void FrameScheduler::run()
+  {
+    std::unique_lock lock(mutex);
+    std::optional<Preset::TimePoint> next;
+
+    while (true)
+    {
+      auto due = [this]()
+      { return woken || !running; };
+      if (next)
+        wakeup.wait_until(lock, *next, due);
+      else
+        wakeup.wait(lock, due);
+
+      if (!running)
+        return;
+      woken = false;
+
+      // Panels are ticked without holding the lock, so the GUI thread can keep adding and waking
+      ticking = panels;
+      lock.unlock();
+      next = tick();
+      lock.lock();
+      ticking.clear();
+      tickDone.notify_all();
+
+      if (!next)
+        LOG_TRACE("Nothing to render, scheduler going idle");
+    }
+  }
+
+  auto FrameScheduler::tick() -> std::optional<Preset::TimePoint>
+  {
+    auto now = std::chrono::steady_clock::now();
+
+    std::optional<Preset::TimePoint> next = span.tick(now, ticking);
+    for (const auto& panel : ticking)
+    {
+      if (auto due = panel->tick(now); due && (!next || *due < *next))
+      {
+        next = due;
+      }
+    }
+    return next;
+  }
+} // namespace fw16led::managers
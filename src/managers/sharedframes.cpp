@@ -0,0 +1,155 @@
+#include "fw16led/managers/sharedframes.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fw16led::managers
+{
+  /**
+   * @brief Attempts to read a slot the producer keeps overwriting before the frame is skipped.
+   */
+  inline constexpr int READ_ATTEMPTS = 4;
+
+#ifdef __linux__
+  auto SharedFrameRing::create(const std::string& name, std::function<void()> onFrame) -> std::unique_ptr<SharedFrameRing>
+  {
+    // A daemon that crashed may have left the object behind
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+      LOG_ERROR("Could not create shared memory {}: {}", name, std::strerror(errno));
+      return nullptr;
+    }
+
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, sizeof(SharedFrameLayout)) == 0)
+      memory = mmap(nullptr, sizeof(SharedFrameLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+      LOG_ERROR("Could not map shared memory {}: {}", name, std::strerror(error));
+      shm_unlink(name.c_str());
+      return nullptr;
+    }
+
+    // The object starts out zeroed, so every slot is empty
+    auto* layout = new (memory) SharedFrameLayout{};
+    layout->magic = SharedFrameLayout::MAGIC;
+    layout->version = SharedFrameLayout::VERSION;
+    layout->slotCount = SharedFrameLayout::SLOTS;
+    layout->slotSize = sizeof(SharedFrameSlot);
+
+    LOG_INFO("Created shared frame ring {}", name);
+    return std::unique_ptr<SharedFrameRing>(new SharedFrameRing(name, layout, std::move(onFrame)));
+  }
+
+  SharedFrameRing::SharedFrameRing(std::string name, SharedFrameLayout* layout, std::function<void()> onFrame)
+    : name(std::move(name))
+    , layout(layout)
+    , onFrame(std::move(onFrame))
+    , thread(&SharedFrameRing::run, this)
+  {
+  }
+
+  SharedFrameRing::~SharedFrameRing()
+  {
+    // The thread may have checked running just before it started waiting, so keep waking it until it left
+    running = false;
+    while (!stopped.load(std::memory_order_acquire))
+    {
+      syscall(SYS_futex, &layout->published, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+      std::this_thread::yield();
+    }
+    thread.join();
+
+    munmap(layout, sizeof(SharedFrameLayout));
+    shm_unlink(name.c_str());
+  }
+
+  void SharedFrameRing::run()
+  {
+    // The futex is shared with another process, so it must not be FUTEX_PRIVATE_FLAG
+    uint32_t seen = get_published();
+    while (running)
+    {
+      syscall(SYS_futex, &layout->published, FUTEX_WAIT, seen, nullptr, nullptr, 0);
+
+      uint32_t published = get_published();
+      if (published != seen)
+      {
+        seen = published;
+        onFrame();
+      }
+    }
+    stopped.store(true, std::memory_order_release);
+  }
+#else
+  auto SharedFrameRing::create(const std::string& /*name*/, std::function<void()> /*onFrame*/) -> std::unique_ptr<SharedFrameRing>
+  {
+    LOG_WARN("Shared frame rings are only supported on Linux");
+    return nullptr;
+  }
+
+  SharedFrameRing::~SharedFrameRing() = default;
+#endif
+
+  auto SharedFrameRing::get_published() const -> uint32_t
+  {
+    return layout->published.load(std::memory_order_acquire);
+  }
+
+  auto SharedFrameRing::take_latest(uint32_t& seen, bool& grey, ledmatrix::Frame& bits, ledmatrix::Framebuffer& pixels) -> bool
+  {
+    for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt)
+    {
+      uint32_t published = get_published();
+      if (published == seen)
+        return false;
+
+      // Frame n is complete once its slot's sequence is 2n + 2, and unchanged while it was copied
+      uint32_t frame = published - 1;
+      const auto& slot = layout->ring[frame % SharedFrameLayout::SLOTS];
+      uint32_t complete = 2 * frame + 2;
+      if (slot.sequence.load(std::memory_order_acquire) != complete)
+        continue;
+
+      grey = slot.grey != 0;
+      if (grey)
+      {
+        for (int x = 0; x < ledmatrix::WIDTH; ++x)
+        {
+          for (int y = 0; y < ledmatrix::HEIGHT; ++y)
+            pixels.at(x, y) = slot.pixels[x * ledmatrix::HEIGHT + y];
+        }
+      }
+      else
+      {
+        std::copy(slot.bits.begin(), slot.bits.end(), bits.begin());
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != complete)
+        continue;
+
+      seen = published;
+      return true;
+    }
+
+    LOG_DEBUG("Shared frame ring {} is overwritten faster than it can be read", name);
+    seen = get_published();
+    return false;
+  }
+} // namespace fw16led::managers
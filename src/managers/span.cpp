@@ -0,0 +1,150 @@
+#include "fw16led/managers/span.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace fw16led::managers
+{
+  void PanelSpan::start(std::unique_ptr<CanvasPreset> preset)
+  {
+    showing = false;
+    std::lock_guard lock(mutex);
+    pending = PendingChange{std::move(preset), true};
+  }
+
+  void PanelSpan::show(const ledmatrix::Canvas& canvas)
+  {
+    streamed.back() = canvas;
+    streamed.publish();
+
+    if (!showing)
+    {
+      showing = true;
+      std::lock_guard lock(mutex);
+      pending = PendingChange{nullptr, true};
+    }
+  }
+
+  void PanelSpan::stop()
+  {
+    showing = false;
+    std::lock_guard lock(mutex);
+    pending = PendingChange{nullptr, false};
+  }
+
+  auto PanelSpan::get_stats() -> SpanStats
+  {
+    std::lock_guard lock(mutex);
+    return stats;
+  }
+
+  auto PanelSpan::tick(Preset::TimePoint now, std::span<const std::shared_ptr<LedPanel>> panels) -> std::optional<Preset::TimePoint>
+  {
+    std::optional<PendingChange> change;
+    {
+      std::lock_guard lock(mutex);
+      change = std::exchange(pending, std::nullopt);
+    }
+    if (change)
+    {
+      if (preset)
+        preset->exit();
+      preset = std::move(change->preset);
+      active = change->active;
+      canvas = ledmatrix::Canvas(0);
+      LOG_DEBUG("Span {}", active ? (preset ? "rendering a preset" : "showing streamed canvases") : "stopped");
+    }
+
+    measureSkew(panels);
+
+    // Keeps the panels from installing their own presets over the canvas, panels attached later included
+    for (const auto& panel : panels)
+      panel->setSpanned(active);
+    if (!active)
+      return std::nullopt;
+
+    members.clear();
+    for (const auto& panel : panels)
+      members.push_back(panel.get());
+    std::ranges::sort(members, {}, &LedPanel::getId);
+    if (members.empty())
+      return std::nullopt;
+
+    // Panels came or went, so the preset has to lay out its content again
+    bool resized = canvas.panel_count() != static_cast<int>(members.size());
+    if (resized)
+    {
+      canvas = ledmatrix::Canvas(static_cast<int>(members.size()));
+      if (preset)
+      {
+        preset->init(canvas.width());
+        nextFrame = now;
+      }
+    }
+
+    if (preset)
+    {
+      if (nextFrame && *nextFrame <= now)
+      {
+        nextFrame = preset->render(now, canvas);
+        commit();
+      }
+      return nextFrame;
+    }
+
+    if (streamed.take() && streamed.front().panel_count() == canvas.panel_count())
+    {
+      canvas = streamed.front();
+      commit();
+    }
+    return std::nullopt;
+  }
+
+  void PanelSpan::commit()
+  {
+    // A panel that already shows its part elides the frame and cannot be measured
+    measured.clear();
+    committedAt = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < members.size(); ++i)
+    {
+      auto matrix = members[i]->getLedMatrix();
+      auto sent = matrix->get_frame_stats().sent;
+      canvas.copy_panel(static_cast<int>(i), part);
+      members[i]->showSpanned(part);
+      if (matrix->get_frame_stats().sent != sent)
+        measured.push_back(members[i]->getId());
+    }
+
+    std::lock_guard lock(mutex);
+    stats.commits++;
+  }
+
+  void PanelSpan::measureSkew(std::span<const std::shared_ptr<LedPanel>> panels)
+  {
+    if (measured.size() < 2)
+      return;
+
+    // Wait until every panel accepted the canvas, a panel that went away cancels the measurement
+    auto first = std::chrono::steady_clock::time_point::max();
+    auto last = std::chrono::steady_clock::time_point::min();
+    for (uint8_t id : measured)
+    {
+      auto panel = std::ranges::find(panels, id, &LedPanel::getId);
+      if (panel == panels.end())
+      {
+        measured.clear();
+        return;
+      }
+
+      auto shown = (*panel)->getLedMatrix()->get_last_frame_shown();
+      if (shown < committedAt)
+        return;
+      first = std::min(first, shown);
+      last = std::max(last, shown);
+    }
+    measured.clear();
+
+    std::lock_guard lock(mutex);
+    stats.skew.record(std::chrono::duration_cast<std::chrono::microseconds>(last - first));
+  }
+} // namespace fw16led::managers
@@ -1,8 +1,21 @@
 #include "fw16led/managers/usb.hpp"
+#include "fw16led/ledmatrix/simulator.hpp"
+#include "fw16led/ledmatrix/usbtransport.hpp"
+#include "fw16led/managers/metrics.hpp"
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QTimer>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
 #include <vector>
 
 namespace fw16led::managers
 {
+  inline constexpr int OPEN_RETRIES = 5;
+  inline constexpr int OPEN_RETRY_DELAY_MS = 200;
+  inline constexpr auto METRICS_INTERVAL = std::chrono::seconds(1);
 
   UsbManager::UsbManager()
   {
@@ -11,9 +24,106 @@ namespace fw16led::managers
     if (r < 0)
     {
       SPDLOG_CRITICAL("Failed to initialize libusb: {}", r);
+      libusb_ctx = nullptr;
       return;
     }
 
+    // Transfers and hotplug events are dispatched on the event thread, so it has to run before any panel exists
+    engine = std::make_unique<ledmatrix::TransferEngine>(libusb_ctx);
+  }
+
+  UsbManager::~UsbManager()
+  {
+    if (hotplugRegistered)
+    {
+      libusb_hotplug_deregister_callback(libusb_ctx, hotplugHandle);
+    }
+
+    SPDLOG_DEBUG("Freeing usb resources");
+    for (const auto& panel : ledpanels)
+      scheduler.remove(panel);
+    ledpanels.clear();
+    engine.reset();
+
+    if (libusb_ctx)
+    {
+      SPDLOG_DEBUG("Exiting libusb");
+      libusb_exit(libusb_ctx);
+    }
+  };
+
+  void UsbManager::start()
+  {
+    if (!libusb_ctx)
+      return;
+
+    if (const char* simulated = std::getenv("FW16LED_SIMULATED_PANELS"))
+    {
+      QTimer::singleShot(0, [this, count = std::atoi(simulated)]()
+                         { addSimulatedPanels(count); });
+    }
+
+    if (const char* metricsFile = std::getenv("FW16LED_METRICS_FILE"))
+    {
+      LOG_INFO("Writing panel metrics to {}", metricsFile);
+      metricsTimer = std::make_unique<QTimer>();
+      QObject::connect(metricsTimer.get(), &QTimer::timeout, [this, path = QString::fromLocal8Bit(metricsFile)]()
+                       { writeMetrics(path, ledpanels, scheduler.get_span().get_stats()); });
+      metricsTimer->start(METRICS_INTERVAL);
+    }
+
+    if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG))
+    {
+      LOG_INFO("Hotplug is not supported on this platform, scanning for devices once");
+      QTimer::singleShot(0, [this]()
+                         { scan(); });
+      return;
+    }
+
+    // With LIBUSB_HOTPLUG_ENUMERATE the callback also fires for devices that are already connected
+    int r = libusb_hotplug_register_callback(
+        libusb_ctx,
+        LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+        LIBUSB_HOTPLUG_ENUMERATE,
+        ledmatrix::VID,
+        ledmatrix::PID,
+        LIBUSB_HOTPLUG_MATCH_ANY,
+        &UsbManager::on_hotplug,
+        this,
+        &hotplugHandle);
+    if (r != LIBUSB_SUCCESS)
+    {
+      LOG_ERROR("Could not register hotplug callback: {}", libusb_strerror((libusb_error) r));
+      QTimer::singleShot(0, [this]()
+                         { scan(); });
+      return;
+    }
+
+    hotplugRegistered = true;
+    LOG_DEBUG("Listening for LED matrix hotplug events");
+  }
+
+  int LIBUSB_CALL UsbManager::on_hotplug(libusb_context* /*context*/, libusb_device* device, libusb_hotplug_event event, void* userData)
+  {
+    auto* self = static_cast<UsbManager*>(userData);
+
+    // Hotplug callbacks must not do synchronous I/O, so opening and closing happens on the main thread
+    libusb_ref_device(device);
+    QMetaObject::invokeMethod(
+        QCoreApplication::instance(), [self, device, event]()
+        {
+          if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED)
+            self->attach(device);
+          else
+            self->detach(device);
+          libusb_unref_device(device); },
+        Qt::QueuedConnection);
+
+    return 0;
+  }
+
+  void UsbManager::scan()
+  {
     // Get the list of USB devices
     LOG_DEBUG("Listing USB devices");
     libusb_device** dev_list = nullptr;
@@ -21,7 +131,6 @@ namespace fw16led::managers
     if (cnt < 0)
     {
       SPDLOG_CRITICAL("Failed to get device list: {}", cnt);
-      libusb_exit(libusb_ctx);
       return;
     }
 
@@ -36,58 +145,7 @@ namespace fw16led::managers
         // Check if it matches VID=0x32AC and PID=0x0020
         if (desc.idVendor == ledmatrix::VID && desc.idProduct == ledmatrix::PID)
         {
-          LOG_DEBUG("Found Framework LED Matrix device");
-
-          // Attempt to open this device
-          libusb_device_handle* handle = nullptr;
-          r = libusb_open(device, &handle);
-          if (r == 0 && handle != nullptr)
-          {
-            LOG_DEBUG("-> Successfully opened device.");
-
-            r = libusb_set_configuration(handle, 1);
-            if (r != LIBUSB_SUCCESS && r != LIBUSB_ERROR_BUSY)
-            {
-              LOG_ERROR("-> Failed to set configuration: {}", libusb_strerror((libusb_error) r));
-              libusb_close(handle);
-              continue;
-            }
-
-#ifdef __linux__
-            // On Linux, if a kernel driver is attached, detach it.
-            if (libusb_kernel_driver_active(handle, 1) == 1)
-            {
-              r = libusb_detach_kernel_driver(handle, 1);
-              if (r != LIBUSB_SUCCESS)
-              {
-                LOG_ERROR("-> Could not detach kernel driver: {}", libusb_strerror((libusb_error) r));
-                libusb_close(handle);
-                continue;
-              }
-            }
-
-            LOG_DEBUG("-> Successfully detached kernel driver");
-#endif
-
-            // Claim the interface
-            int interfaceNum = 1;
-            r = libusb_claim_interface(handle, interfaceNum);
-            if (r != LIBUSB_SUCCESS)
-            {
-              LOG_ERROR("-> Could not claim interface 1: {}", libusb_strerror((libusb_error) r));
-              libusb_close(handle);
-              continue;
-            }
-
-            LOG_DEBUG("-> Successfully claimed interface 1");
-
-            // Store the handle
-            ledpanels.push_back(std::make_shared<LedPanel>(std::make_shared<ledmatrix::LedMatrix>(handle)));
-          }
-          else
-          {
-            LOG_ERROR("-> Failed to open device: {}", r);
-          }
+          attach(device);
         }
       }
       else
@@ -99,14 +157,150 @@ namespace fw16led::managers
     libusb_free_device_list(dev_list, 1);
   }
 
-  UsbManager::~UsbManager()
+  void UsbManager::attach(libusb_device* device, int attempt)
   {
-    SPDLOG_DEBUG("Freeing usb resources");
-    ledpanels.clear();
+    for (const auto& panel : ledpanels)
+    {
+      if (panel->getLedMatrix()->get_device() == device)
+        return;
+    }
 
-    SPDLOG_DEBUG("Exiting libusb");
-    libusb_exit(libusb_ctx);
-  };
+    LOG_DEBUG("Found Framework LED Matrix device");
+
+    // Attempt to open this device
+    libusb_device_handle* handle = nullptr;
+    int r = libusb_open(device, &handle);
+    if (r == LIBUSB_ERROR_ACCESS && attempt < OPEN_RETRIES)
+    {
+      // Freshly attached devices may not have their permissions set up yet
+      LOG_DEBUG("-> Device not accessible yet, retrying");
+      libusb_ref_device(device);
+      QTimer::singleShot(OPEN_RETRY_DELAY_MS, [this, device, attempt]()
+                         {
+                           attach(device, attempt + 1);
+                           libusb_unref_device(device); });
+      return;
+    }
+    if (r != 0 || handle == nullptr)
+    {
+      LOG_ERROR("-> Failed to open device: {}", r);
+      return;
+    }
+
+    LOG_DEBUG("-> Successfully opened device.");
+
+    r = libusb_set_configuration(handle, 1);
+    if (r != LIBUSB_SUCCESS && r != LIBUSB_ERROR_BUSY)
+    {
+      LOG_ERROR("-> Failed to set configuration: {}", libusb_strerror((libusb_error) r));
+      libusb_close(handle);
+      return;
+    }
+
+#ifdef __linux__
+    // On Linux, if a kernel driver is attached, detach it.
+    if (libusb_kernel_driver_active(handle, 1) == 1)
+    {
+      r = libusb_detach_kernel_driver(handle, 1);
+      if (r != LIBUSB_SUCCESS)
+      {
+        LOG_ERROR("-> Could not detach kernel driver: {}", libusb_strerror((libusb_error) r));
+        libusb_close(handle);
+        return;
+      }
+    }
+
+    LOG_DEBUG("-> Successfully detached kernel driver");
+#endif
+
+    // Claim the interface
+    int interfaceNum = 1;
+    r = libusb_claim_interface(handle, interfaceNum);
+    if (r != LIBUSB_SUCCESS)
+    {
+      LOG_ERROR("-> Could not claim interface 1: {}", libusb_strerror((libusb_error) r));
+      libusb_close(handle);
+      return;
+    }
+
+    LOG_DEBUG("-> Successfully claimed interface 1");
+
+    // Settings are keyed by where the panel is plugged in, not by the order it was found in
+    auto location = PanelIdentityStore::locationOf(device, handle);
+    auto assigned = identities.idFor(location, attachedIds());
+    if (!assigned || std::any_of(ledpanels.begin(), ledpanels.end(), [id = *assigned](const auto& panel)
+                                 { return panel->getId() == id; }))
+    {
+      if (assigned)
+        LOG_ERROR("-> Panel at {} has the same id {} as an already connected panel", location, *assigned);
+      libusb_release_interface(handle, interfaceNum);
+      libusb_close(handle);
+      return;
+    }
+    uint8_t id = *assigned;
+    LOG_DEBUG("-> Panel at {} has id {}", location, id);
+
+    // Store the handle
+    addPanel(std::make_shared<LedPanel>(id, std::make_shared<ledmatrix::LedMatrix>(std::make_unique<ledmatrix::LibusbTransport>(handle, *engine))));
+  }
+
+  void UsbManager::addSimulatedPanels(int count)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      auto location = "simulated-" + std::to_string(i);
+      auto assigned = identities.idFor(location, attachedIds());
+      if (!assigned)
+        continue;
+      uint8_t id = *assigned;
+      if (std::any_of(ledpanels.begin(), ledpanels.end(), [id](const auto& panel)
+                      { return panel->getId() == id; }))
+      {
+        LOG_ERROR("Simulated panel {} has the same id {} as an already connected panel", i, id);
+        continue;
+      }
+
+      LOG_INFO("Adding simulated panel with id {}", id);
+      auto transport = std::make_unique<ledmatrix::SimulatedTransport>(std::make_shared<ledmatrix::SimulatedPanel>(i), *engine);
+      addPanel(std::make_shared<LedPanel>(id, std::make_shared<ledmatrix::LedMatrix>(std::move(transport))));
+    }
+  }
+
+  auto UsbManager::attachedIds() const -> std::vector<uint8_t>
+  {
+    std::vector<uint8_t> ids;
+    for (const auto& panel : ledpanels)
+      ids.push_back(panel->getId());
+    return ids;
+  }
+
+  void UsbManager::addPanel(std::shared_ptr<LedPanel> panel)
+  {
+    ledpanels.push_back(panel);
+
+    // Listeners may reconfigure the panel, which is cheapest before its first tick
+    for (const auto& listener : panelAddedListeners)
+      listener(panel);
+
+    scheduler.add(panel);
+  }
+
+  void UsbManager::detach(libusb_device* device)
+  {
+    auto it = std::find_if(ledpanels.begin(), ledpanels.end(), [device](const auto& panel)
+                           { return panel->getLedMatrix()->get_device() == device; });
+    if (it == ledpanels.end())
+      return;
+
+    auto panel = *it;
+    LOG_INFO("LedPanel with id {} was disconnected", panel->getId());
+    scheduler.remove(panel);
+
+    for (const auto& listener : panelRemovedListeners)
+      listener(panel);
+
+    ledpanels.erase(it);
+  }
 
   void UsbManager::applyConfig(uint8_t panelId)
   {
@@ -115,8 +309,53 @@ namespace fw16led::managers
       if (panel->getId() == panelId)
       {
         panel->applyConfig();
+        scheduler.wake();
         return;
       }
     }
   }
-} // namespace fw16led::managers
\ No newline at end of file
+
+  void UsbManager::startSpan(std::unique_ptr<CanvasPreset> preset)
+  {
+    scheduler.get_span().start(std::move(preset));
+    scheduler.wake();
+  }
+
+  void UsbManager::showCanvas(const ledmatrix::Canvas& canvas)
+  {
+    scheduler.get_span().show(canvas);
+    scheduler.wake();
+  }
+
+  void UsbManager::stopSpan()
+  {
+    scheduler.get_span().stop();
+    for (const auto& panel : ledpanels)
+      panel->applyConfig();
+    scheduler.wake();
+  }
+
+  auto UsbManager::mapSharedFrames(uint8_t panelId, const std::string& prefix) -> std::string
+  {
+    for (const auto& panel : ledpanels)
+    {
+      if (panel->getId() != panelId)
+        continue;
+
+      // Producers of the same panel share its ring
+      if (!panel->getSharedFramesName().empty())
+        return panel->getSharedFramesName();
+
+      // The ring only rings the doorbell, reading it is left to the render thread
+      auto ring = SharedFrameRing::create(prefix + "-panel-" + std::to_string(panelId), [this]()
+                                          { scheduler.wake(); });
+      if (!ring)
+        return {};
+
+      panel->attachSharedFrames(std::move(ring));
+      scheduler.wake();
+      return panel->getSharedFramesName();
+    }
+    return {};
+  }
+} // namespace fw16led::managers
@@ -0,0 +1,53 @@
+#include "Animation.hpp"
+#include "fw16led/PresetOption.hpp"
+#include <string>
+#include <vector>
+
+namespace fw16led::presets
+{
+  constexpr auto ID = "animation";
+  constexpr auto DISPLAY_NAME = "Animation";
+  const auto SETTINGS = std::vector<PresetOptionConfig>{
+      PresetOptionConfig{
+          .type = PresetOptionType::Text,
+          .key = "file",
+          .label = "Animation file",
+          .defaultText = ""},
+      PresetOptionConfig{
+          .type = PresetOptionType::Checkbox,
+          .key = "loop",
+          .label = "Loop",
+          .defaultBool = true},
+  };
+
+  Animation::Animation()
+    : Preset(ID, DISPLAY_NAME)
+  {
+  }
+
+  void Animation::init(std::shared_ptr<ledmatrix::LedMatrix> panel)
+  {
+    this->panel = panel;
+    player.setLoop(getOptionValue<bool>("loop").value_or(true));
+
+    auto path = getOptionValue<std::string>("file").value_or("");
+    if (!path.empty())
+      player.open(path);
+  }
+
+  void Animation::exit()
+  {
+    player.close();
+  }
+
+  std::optional<Preset::TimePoint> Animation::render(TimePoint now)
+  {
+    return player.render(now, *panel);
+  }
+
+  void Animation::registerPreset(std::shared_ptr<PresetRegistry> registry)
+  {
+    registry->registerPreset(ID, DISPLAY_NAME, []()
+                             { return std::make_unique<fw16led::presets::Animation>(); }, SETTINGS);
+  }
+} // namespace fw16led::presets
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "AnimationPlayer.hpp"
+#include "fw16led/Preset.hpp"
+#include "fw16led/PresetRegistry.hpp"
+
+namespace fw16led::presets
+{
+  /**
+   * @brief Plays an animation file, see ledmatrix::AnimationView.
+   */
+  class Animation : public Preset
+  {
+  public:
+    Animation();
+    virtual ~Animation() = default;
+    void init(std::shared_ptr<ledmatrix::LedMatrix> panel) override;
+    void exit() override;
+    std::optional<TimePoint> render(TimePoint now) override;
+    static void registerPreset(std::shared_ptr<PresetRegistry> registry);
+
+  private:
+    std::shared_ptr<ledmatrix::LedMatrix> panel;
+    AnimationPlayer player;
+  };
+
+} // namespace fw16led::presets
@@ -0,0 +1,85 @@
+#include "AnimationPlayer.hpp"
+#include "fw16led/global.hpp"
+#include <span>
+
+namespace fw16led::presets
+{
+  bool AnimationPlayer::open(const std::string& path)
+  {
+    close();
+    file.setFileName(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      LOG_WARN("Cannot open animation {}: {}", path, file.errorString().toStdString());
+      return false;
+    }
+
+    // Mapped instead of read, so the pages of long animations are only loaded once they are shown
+    auto size = file.size();
+    uchar* data = file.map(0, size);
+    if (!data)
+    {
+      LOG_WARN("Cannot map animation {}: {}", path, file.errorString().toStdString());
+      close();
+      return false;
+    }
+
+    view = ledmatrix::AnimationView::parse(std::span<const uint8_t>(data, static_cast<size_t>(size)));
+    if (!view)
+    {
+      LOG_WARN("{} is not a valid animation", path);
+      close();
+      return false;
+    }
+
+    length = {};
+    for (size_t i = 0; i < view->frame_count(); ++i)
+      length += view->duration(i);
+    LOG_DEBUG("Playing {} frames of {} ms from {}", view->frame_count(), length.count(), path);
+    return true;
+  }
+
+  void AnimationPlayer::close()
+  {
+    view.reset();
+    file.close();
+    index = 0;
+    frameEnd.reset();
+  }
+
+  std::optional<Preset::TimePoint> AnimationPlayer::render(Preset::TimePoint now, ledmatrix::LedMatrix& panel)
+  {
+    if (!view)
+      return std::nullopt;
+
+    if (!frameEnd)
+    {
+      frameEnd = now + view->duration(index);
+    }
+    else
+    {
+      // Resynchronise after a long stall instead of racing through every missed frame
+      if (now - *frameEnd > length)
+        frameEnd = now;
+
+      // Skip frames that ended while the tick was late, so the animation keeps its speed
+      while (now >= *frameEnd)
+      {
+        if (index + 1 < view->frame_count())
+          index++;
+        else if (loop)
+          index = 0;
+        else
+          return std::nullopt;
+        *frameEnd += view->duration(index);
+      }
+    }
+
+    // Frames point into the mapped file and go to the transport as they are
+    if (view->get_format() == ledmatrix::AnimationFormat::Grey)
+      panel.draw_grey(view->grey(index));
+    else
+      panel.draw(view->bits(index));
+    return frameEnd;
+  }
+} // namespace fw16led::presets
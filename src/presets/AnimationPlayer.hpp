@@ -0,0 +1,42 @@
+#pragma once
+
+#include "fw16led/Preset.hpp"
+#include "fw16led/ledmatrix/animation.hpp"
+#include "fw16led/ledmatrix/ledmatrix.hpp"
+#include <QFile>
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace fw16led::presets
+{
+  /**
+   * @brief Plays an animation file on a panel, for presets showing animations.
+   */
+  class AnimationPlayer
+  {
+  public:
+    /**
+     * @brief Map an animation file and start playing it from the first frame.
+     */
+    bool open(const std::string& path);
+    void close();
+
+    void setLoop(bool loop) { this->loop = loop; }
+
+    /**
+     * @brief Show the frame that is due.
+     * @return When the next frame is due, or std::nullopt once a single play is over or nothing is open.
+     */
+    std::optional<Preset::TimePoint> render(Preset::TimePoint now, ledmatrix::LedMatrix& panel);
+
+  private:
+    QFile file; /**< Stays open while playing, closing it removes the mapping the view points into. */
+    std::optional<ledmatrix::AnimationView> view;
+    std::chrono::milliseconds length{}; /**< Duration of all frames together. */
+    bool loop = true;
+    size_t index = 0;
+    std::optional<Preset::TimePoint> frameEnd; /**< When the frame being shown is replaced by the next one. */
+  };
+
+} // namespace fw16led::presets
@@ -22,15 +22,20 @@ namespace fw16led::presets
           .defaultDropdown = 1},
   };
 
+  /**
+   * @brief Render slightly after the minute changed, so that timer jitter never shows the old time.
+   */
+  constexpr auto MINUTE_SLACK = std::chrono::milliseconds(20);
+
   Clock::Clock()
     : Preset(ID, DISPLAY_NAME)
   {
   }
 
-  void Clock::render()
+  std::optional<Preset::TimePoint> Clock::render(TimePoint now)
   {
-    auto now = std::chrono::system_clock::now();
-    auto now_time_t = std::chrono::system_clock::to_time_t(now);
+    auto wallNow = std::chrono::system_clock::now();
+    auto now_time_t = std::chrono::system_clock::to_time_t(wallNow);
 
     std::tm local_time;
 #if defined(_MSC_VER)
@@ -39,7 +44,7 @@ namespace fw16led::presets
     localtime_r(&now_time_t, &local_time);
 #endif
 
-    auto format = getOptionValue<int>("format");
+    auto format = formatOption ? getOptionValue<int>(*formatOption) : std::nullopt;
     if (format == 0)
     {
       // Format the time as HH:MM AM/PM
@@ -56,28 +61,20 @@ namespace fw16led::presets
       std::string current_time = time_stream.str();
       panel->pattern_text(current_time);
     }
+
+    // Only the minutes are shown, so the next change happens on the next wall clock minute
+    auto nextMinute = std::chrono::floor<std::chrono::minutes>(wallNow) + std::chrono::minutes(1);
+    return now + (nextMinute - wallNow) + MINUTE_SLACK;
   }
 
   void Clock::init(std::shared_ptr<ledmatrix::LedMatrix> panel)
   {
     this->panel = panel;
-
-    timer = new QTimer();
-    QObject::connect(timer, &QTimer::timeout, [this]()
-                     { this->render(); });
-    timer->start(1000);
-
-    render();
+    formatOption = getOptionIndex("format");
   }
 
   void Clock::exit()
   {
-    delete timer;
-  }
-
-  std::vector<PresetOptionConfig> Clock::getOptions() const
-  {
-    return SETTINGS;
   }
 
   void Clock::registerPreset(std::shared_ptr<PresetRegistry> registry)
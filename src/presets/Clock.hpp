@@ -2,7 +2,6 @@
 
 #include "fw16led/Preset.hpp"
 #include "fw16led/PresetRegistry.hpp"
-#include <QTimer>
 
 namespace fw16led::presets
 {
@@ -13,13 +12,12 @@ namespace fw16led::presets
     virtual ~Clock() = default;
     void init(std::shared_ptr<ledmatrix::LedMatrix> panel) override;
     void exit() override;
-    std::vector<PresetOptionConfig> getOptions() const override;
+    std::optional<TimePoint> render(TimePoint now) override;
     static void registerPreset(std::shared_ptr<PresetRegistry> registry);
 
   private:
     std::shared_ptr<ledmatrix::LedMatrix> panel;
-    QTimer* timer;
-    void render();
+    std::optional<size_t> formatOption; /**< Looked up once in init(), the format is read on every render. */
   };
 
 } // namespace fw16led::presets
@@ -41,21 +41,10 @@ namespace fw16led::presets
 
     auto scroll = getOptionValue<bool>("scroll");
     panel->animate(scroll.value());
-
-    timer = new QTimer();
-    QObject::connect(timer, &QTimer::timeout, [this]()
-                     { this->panel->keep_awake(); });
-    timer->start(1000);
   }
 
   void Gradient::exit()
   {
-    delete timer;
-  }
-
-  std::vector<PresetOptionConfig> Gradient::getOptions() const
-  {
-    return SETTINGS;
   }
 
   void Gradient::registerPreset(std::shared_ptr<PresetRegistry> registry)
@@ -0,0 +1,104 @@
+#include "Image.hpp"
+#include "fw16led/PresetOption.hpp"
+#include "fw16led/managers/imageimport.hpp"
+#include <string>
+#include <vector>
+
+namespace fw16led::presets
+{
+  constexpr auto ID = "image";
+  constexpr auto DISPLAY_NAME = "Image";
+  const auto SETTINGS = std::vector<PresetOptionConfig>{
+      PresetOptionConfig{
+          .type = PresetOptionType::Text,
+          .key = "file",
+          .label = "Image or GIF",
+          .defaultText = ""},
+      PresetOptionConfig{
+          .type = PresetOptionType::Dropdown,
+          .key = "mode",
+          .label = "Mode",
+          .dropdownOptions = {
+              DropdownOption(0, "Greyscale"),
+              DropdownOption(1, "Black and white")},
+          .defaultDropdown = 0},
+      PresetOptionConfig{
+          .type = PresetOptionType::Checkbox,
+          .key = "dither",
+          .label = "Dither black and white",
+          .defaultBool = true},
+      PresetOptionConfig{
+          .type = PresetOptionType::NumberRange,
+          .key = "gamma",
+          .label = "Gamma",
+          .minValue = 1.0,
+          .maxValue = 3.0,
+          .defaultNumber = 2.2,
+          .isInteger = false},
+      PresetOptionConfig{
+          .type = PresetOptionType::Checkbox,
+          .key = "loop",
+          .label = "Loop",
+          .defaultBool = true},
+  };
+
+  /**
+   * @brief How often to check whether the conversion finished. Cached images are ready at the first check.
+   */
+  constexpr auto CONVERSION_POLL = std::chrono::milliseconds(20);
+
+  Image::Image()
+    : Preset(ID, DISPLAY_NAME)
+  {
+  }
+
+  void Image::init(std::shared_ptr<ledmatrix::LedMatrix> panel)
+  {
+    this->panel = panel;
+    player.setLoop(getOptionValue<bool>("loop").value_or(true));
+
+    auto path = getOptionValue<std::string>("file").value_or("");
+    if (path.empty())
+      return;
+
+    managers::ImageImportOptions options;
+    options.format = getOptionValue<int>("mode").value_or(0) == 1 ? ledmatrix::AnimationFormat::Bits : ledmatrix::AnimationFormat::Grey;
+    options.dither = getOptionValue<bool>("dither").value_or(true);
+    options.gamma = getOptionValue<double>("gamma").value_or(2.2);
+
+    cancelled = false;
+    conversion = std::async(std::launch::async, [this, path = QString::fromStdString(path), options]()
+                            { return managers::importImage(path, options, cancelled); });
+  }
+
+  void Image::exit()
+  {
+    if (conversion.valid())
+    {
+      cancelled = true;
+      conversion.wait();
+      conversion = {};
+    }
+    player.close();
+  }
+
+  std::optional<Preset::TimePoint> Image::render(TimePoint now)
+  {
+    if (conversion.valid())
+    {
+      if (conversion.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return now + CONVERSION_POLL;
+
+      auto animation = conversion.get();
+      if (!animation || !player.open(animation->toStdString()))
+        return std::nullopt;
+    }
+    return player.render(now, *panel);
+  }
+
+  void Image::registerPreset(std::shared_ptr<PresetRegistry> registry)
+  {
+    registry->registerPreset(ID, DISPLAY_NAME, []()
+                             { return std::make_unique<fw16led::presets::Image>(); }, SETTINGS);
+  }
+} // namespace fw16led::presets
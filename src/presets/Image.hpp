@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AnimationPlayer.hpp"
+#include "fw16led/Preset.hpp"
+#include "fw16led/PresetRegistry.hpp"
+#include <QString>
+#include <atomic>
+#include <future>
+#include <optional>
+
+namespace fw16led::presets
+{
+  /**
+   * @brief Shows an image or animated GIF, converted once and cached as an animation file.
+   */
+  class Image : public Preset
+  {
+  public:
+    Image();
+    virtual ~Image() = default;
+    void init(std::shared_ptr<ledmatrix::LedMatrix> panel) override;
+    void exit() override;
+    std::optional<TimePoint> render(TimePoint now) override;
+    static void registerPreset(std::shared_ptr<PresetRegistry> registry);
+
+  private:
+    std::shared_ptr<ledmatrix::LedMatrix> panel;
+    AnimationPlayer player;
+
+    std::future<std::optional<QString>> conversion; /**< Runs in the background, so long GIFs do not hold up the other panels. */
+    std::atomic<bool> cancelled = false;
+  };
+
+} // namespace fw16led::presets
@@ -24,9 +24,10 @@ namespace fw16led::presets
   {
   }
 
-  std::vector<PresetOptionConfig> Off::getOptions() const
+  bool Off::keepsAwake() const
   {
-    return SETTINGS;
+    // Nothing is shown, so the panel may as well go to sleep
+    return false;
   }
 
   void Off::registerPreset(std::shared_ptr<PresetRegistry> registry)
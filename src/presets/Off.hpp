@@ -12,7 +12,7 @@ namespace fw16led::presets
     virtual ~Off() = default;
     void init(std::shared_ptr<ledmatrix::LedMatrix> panel) override;
     void exit() override;
-    std::vector<PresetOptionConfig> getOptions() const override;
+    bool keepsAwake() const override;
     static void registerPreset(std::shared_ptr<PresetRegistry> registry);
   };
 
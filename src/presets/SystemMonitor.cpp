@@ -0,0 +1,159 @@
+#include "SystemMonitor.hpp"
+#include "fw16led/PresetOption.hpp"
+#include "fw16led/global.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace fw16led::presets
+{
+  constexpr auto ID = "system";
+  constexpr auto DISPLAY_NAME = "System monitor";
+
+  enum Metric
+  {
+    Cpu = 0,
+    Memory = 1,
+    Network = 2,
+    Disk = 3,
+    Temperature = 4,
+    Battery = 5,
+  };
+
+  const auto SETTINGS = std::vector<PresetOptionConfig>{
+      PresetOptionConfig{
+          .type = PresetOptionType::Dropdown,
+          .key = "metric",
+          .label = "Metric",
+          .dropdownOptions = {
+              DropdownOption(Cpu, "CPU"),
+              DropdownOption(Memory, "Memory"),
+              DropdownOption(Network, "Network"),
+              DropdownOption(Disk, "Disk"),
+              DropdownOption(Temperature, "Temperature"),
+              DropdownOption(Battery, "Battery")},
+          .defaultDropdown = Cpu},
+      PresetOptionConfig{
+          .type = PresetOptionType::Dropdown,
+          .key = "style",
+          .label = "Style",
+          .dropdownOptions = {
+              DropdownOption(0, "Percentage"),
+              DropdownOption(1, "Graph")},
+          .defaultDropdown = 0},
+  };
+
+  /**
+   * @brief Render slightly after the sampler published, so that timer jitter never shows the old snapshot.
+   */
+  constexpr auto SAMPLE_SLACK = std::chrono::milliseconds(20);
+
+  /**
+   * @brief How long to wait for the first snapshot after subscribing.
+   */
+  constexpr auto FIRST_SAMPLE_POLL = std::chrono::milliseconds(100);
+
+  /**
+   * @brief Network and disk rates are shown relative to the highest recent rate, but never less than this.
+   */
+  constexpr double MIN_RATE_SCALE = 1024.0 * 1024.0;
+
+  /**
+   * @brief Temperature shown as a full bar, in degrees Celsius.
+   */
+  constexpr double MAX_TEMPERATURE = 100.0;
+
+  SystemMonitor::SystemMonitor()
+    : Preset(ID, DISPLAY_NAME)
+  {
+  }
+
+  void SystemMonitor::init(std::shared_ptr<ledmatrix::LedMatrix> panel)
+  {
+    this->panel = panel;
+    metric = getOptionValue<int>("metric").value_or(Cpu);
+    graph = getOptionValue<int>("style").value_or(0) == 1;
+    lastSequence = 0;
+    history.fill(0.0);
+    system_sampler->subscribe();
+  }
+
+  void SystemMonitor::exit()
+  {
+    system_sampler->unsubscribe();
+  }
+
+  std::optional<Preset::TimePoint> SystemMonitor::render(TimePoint now)
+  {
+    auto snapshot = system_sampler->get_snapshot();
+    if (snapshot.sequence == 0)
+      return now + FIRST_SAMPLE_POLL;
+
+    // The sampler runs on its own clock, so only draw snapshots that were not shown yet
+    if (snapshot.sequence != lastSequence)
+    {
+      lastSequence = snapshot.sequence;
+      std::shift_left(history.begin(), history.end(), 1);
+      history.back() = readMetric(snapshot);
+
+      double scale = getScale();
+      if (graph)
+      {
+        std::array<uint8_t, ledmatrix::WIDTH> bars{};
+        for (size_t i = 0; i < history.size(); ++i)
+          bars[i] = static_cast<uint8_t>(std::lround(std::clamp(history[i] / scale, 0.0, 1.0) * ledmatrix::HEIGHT));
+        panel->pattern_equalizer(bars);
+      }
+      else
+      {
+        panel->pattern_percentage(static_cast<uint8_t>(std::lround(std::clamp(history.back() / scale, 0.0, 1.0) * 100)));
+      }
+    }
+
+    auto nextSample = snapshot.time + managers::SystemSampler::SAMPLE_INTERVAL + SAMPLE_SLACK;
+    return nextSample > now ? nextSample : now + FIRST_SAMPLE_POLL;
+  }
+
+  auto SystemMonitor::readMetric(const managers::SystemSnapshot& snapshot) const -> double
+  {
+    // Metrics the system does not provide are shown as empty
+    switch (metric)
+    {
+    case Cpu:
+      return snapshot.cpu.value_or(0.0);
+    case Memory:
+      return snapshot.memory.value_or(0.0);
+    case Network:
+      return snapshot.networkReceive.value_or(0.0) + snapshot.networkTransmit.value_or(0.0);
+    case Disk:
+      return snapshot.diskRead.value_or(0.0) + snapshot.diskWrite.value_or(0.0);
+    case Temperature:
+      return snapshot.temperature.value_or(0.0);
+    case Battery:
+      return snapshot.battery.value_or(0.0);
+    default:
+      return 0.0;
+    }
+  }
+
+  auto SystemMonitor::getScale() const -> double
+  {
+    switch (metric)
+    {
+    case Network:
+    case Disk:
+      return std::max(*std::ranges::max_element(history), MIN_RATE_SCALE);
+    case Temperature:
+      return MAX_TEMPERATURE;
+    default:
+      return 1.0;
+    }
+  }
+
+  void SystemMonitor::registerPreset(std::shared_ptr<PresetRegistry> registry)
+  {
+    registry->registerPreset(ID, DISPLAY_NAME, []()
+                             { return std::make_unique<fw16led::presets::SystemMonitor>(); }, SETTINGS);
+  }
+} // namespace fw16led::presets
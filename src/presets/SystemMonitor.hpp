@@ -0,0 +1,35 @@
+#pragma once
+
+#include "fw16led/Preset.hpp"
+#include "fw16led/PresetRegistry.hpp"
+#include "fw16led/ledmatrix/protocol.hpp"
+#include "fw16led/managers/sampler.hpp"
+#include <array>
+
+namespace fw16led::presets
+{
+  /**
+   * @brief Shows one system metric from the shared SystemSampler, as a percentage or as a graph over time.
+   */
+  class SystemMonitor : public Preset
+  {
+  public:
+    SystemMonitor();
+    virtual ~SystemMonitor() = default;
+    void init(std::shared_ptr<ledmatrix::LedMatrix> panel) override;
+    void exit() override;
+    std::optional<TimePoint> render(TimePoint now) override;
+    static void registerPreset(std::shared_ptr<PresetRegistry> registry);
+
+  private:
+    auto readMetric(const managers::SystemSnapshot& snapshot) const -> double;
+    auto getScale() const -> double;
+
+    std::shared_ptr<ledmatrix::LedMatrix> panel;
+    int metric = 0;
+    bool graph = false;
+    uint64_t lastSequence = 0;
+    std::array<double, ledmatrix::WIDTH> history{}; /**< Latest values, the newest one last. */
+  };
+
+} // namespace fw16led::presets
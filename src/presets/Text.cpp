@@ -14,6 +14,19 @@ namespace fw16led::presets
           .key = "text",
           .label = "Text",
           .defaultText = "LOTUS"},
+      PresetOptionConfig{
+          .type = PresetOptionType::Checkbox,
+          .key = "scroll",
+          .label = "Scroll",
+          .defaultBool = false},
+      PresetOptionConfig{
+          .type = PresetOptionType::NumberRange,
+          .key = "fps",
+          .label = "Scroll speed (rows per second)",
+          .minValue = 1,
+          .maxValue = 60,
+          .defaultNumber = 30,
+          .isInteger = true},
   };
 
   Text::Text()
@@ -26,25 +39,47 @@ namespace fw16led::presets
     this->panel = panel;
 
     auto text = getOptionValue<std::string>("text");
-    if (text.has_value())
+    if (!text.has_value())
+      return;
+
+    if (getOptionValue<bool>("scroll").value_or(false))
+    {
+      marquee.emplace(text.value());
+      stepInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / getOptionValue<double>("fps").value_or(30)));
+      step = 0;
+      nextStep.reset();
+    }
+    else
     {
       panel->pattern_text(text.value());
     }
-
-    timer = new QTimer();
-    QObject::connect(timer, &QTimer::timeout, [this]()
-                     { this->panel->keep_awake(); });
-    timer->start(1000);
   }
 
-  void Text::exit()
+  std::optional<Preset::TimePoint> Text::render(TimePoint now)
   {
-    delete timer;
+    if (!marquee)
+      return std::nullopt;
+
+    if (!nextStep)
+    {
+      nextStep = now;
+    }
+    else
+    {
+      // Skip steps that were missed instead of scrolling slower when a tick comes late
+      auto missed = (now - *nextStep) / stepInterval;
+      step = static_cast<int>((step + 1 + missed) % marquee->length());
+    }
+    *nextStep += stepInterval * ((now - *nextStep) / stepInterval + 1);
+
+    ledmatrix::Frame frame{};
+    marquee->render(step, frame);
+    panel->draw(frame);
+    return nextStep;
   }
 
-  std::vector<PresetOptionConfig> Text::getOptions() const
+  void Text::exit()
   {
-    return SETTINGS;
   }
 
   void Text::registerPreset(std::shared_ptr<PresetRegistry> registry)
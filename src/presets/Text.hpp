@@ -2,7 +2,7 @@
 
 #include "fw16led/Preset.hpp"
 #include "fw16led/PresetRegistry.hpp"
-#include <QTimer>
+#include "fw16led/ledmatrix/marquee.hpp"
 
 namespace fw16led::presets
 {
@@ -13,12 +13,15 @@ namespace fw16led::presets
     virtual ~Text() = default;
     void init(std::shared_ptr<ledmatrix::LedMatrix> panel) override;
     void exit() override;
-    std::vector<PresetOptionConfig> getOptions() const override;
+    std::optional<TimePoint> render(TimePoint now) override;
     static void registerPreset(std::shared_ptr<PresetRegistry> registry);
 
   private:
     std::shared_ptr<ledmatrix::LedMatrix> panel;
-    QTimer* timer;
+    std::optional<ledmatrix::Marquee> marquee;
+    std::chrono::steady_clock::duration stepInterval{};
+    std::optional<TimePoint> nextStep;
+    int step = 0;
   };
 
 } // namespace fw16led::presets
@@ -0,0 +1,73 @@
+#include "Ticker.hpp"
+#include "fw16led/ledmatrix/font.hpp"
+#include "fw16led/ledmatrix/utf8.hpp"
+#include <algorithm>
+#include <string_view>
+
+namespace fw16led::presets
+{
+  /**
+   * @brief First row of the text, which is centred vertically.
+   */
+  constexpr int TICKER_TOP = (ledmatrix::HEIGHT - ledmatrix::FONT_HEIGHT) / 2;
+
+  Ticker::Ticker(const std::string& text, double speed)
+    : stepInterval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / std::max(speed, 1.0))))
+  {
+    // Each glyph is followed by a blank column
+    for (std::string_view rest = text; !rest.empty();)
+    {
+      const auto& glyph = ledmatrix::get_char(ledmatrix::next_code_point(rest));
+      for (int x = 0; x < ledmatrix::FONT_WIDTH; ++x)
+      {
+        uint8_t column = 0;
+        for (int y = 0; y < ledmatrix::FONT_HEIGHT; ++y)
+          column |= ledmatrix::glyph_pixel(glyph, x, y) << y;
+        columns.push_back(column);
+      }
+      columns.push_back(0);
+    }
+  }
+
+  void Ticker::init(int width)
+  {
+    this->width = width;
+    step = 0;
+    nextStep.reset();
+  }
+
+  std::optional<CanvasPreset::TimePoint> Ticker::render(TimePoint now, ledmatrix::Canvas& canvas)
+  {
+    if (!nextStep)
+    {
+      nextStep = now;
+    }
+    else
+    {
+      // Skip steps that were missed instead of scrolling slower when a tick comes late
+      step += 1 + (now - *nextStep) / stepInterval;
+    }
+    *nextStep += stepInterval * ((now - *nextStep) / stepInterval + 1);
+
+    // The text enters on the right and leaves on the left before it starts over
+    size_t length = columns.size() + width;
+    step %= length;
+
+    canvas.fill(0);
+    for (int x = 0; x < width; ++x)
+    {
+      // Column x of the canvas shows column x + step of the strip, which starts with width blank columns
+      size_t column = (x + step) % length;
+      if (column < static_cast<size_t>(width))
+        continue;
+
+      uint8_t bits = columns[column - width];
+      for (int y = 0; y < ledmatrix::FONT_HEIGHT; ++y)
+      {
+        if (bits & (1 << y))
+          canvas.at(x, TICKER_TOP + y) = 0xFF;
+      }
+    }
+    return nextStep;
+  }
+} // namespace fw16led::presets
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "fw16led/CanvasPreset.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fw16led::presets
+{
+  /**
+   * @brief Text scrolling from right to left across all panels of a span.
+   */
+  class Ticker : public CanvasPreset
+  {
+  public:
+    /**
+     * @param speed Columns scrolled per second.
+     */
+    Ticker(const std::string& text, double speed = 15);
+    virtual ~Ticker() = default;
+    void init(int width) override;
+    std::optional<TimePoint> render(TimePoint now, ledmatrix::Canvas& canvas) override;
+
+  private:
+    std::vector<uint8_t> columns; /**< Rasterised text, one bit mask of FONT_HEIGHT rows per column. */
+    int width = 0;
+    std::chrono::steady_clock::duration stepInterval;
+    std::optional<TimePoint> nextStep;
+    size_t step = 0;
+  };
+} // namespace fw16led::presets
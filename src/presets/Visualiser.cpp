@@ -0,0 +1,163 @@
+#include "Visualiser.hpp"
+#include "fw16led/PresetOption.hpp"
+#include "fw16led/ledmatrix/bitmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace fw16led::presets
+{
+  constexpr auto ID = "visualiser";
+  constexpr auto DISPLAY_NAME = "Audio visualiser";
+  const auto SETTINGS = std::vector<PresetOptionConfig>{
+      PresetOptionConfig{
+          .type = PresetOptionType::Text,
+          .key = "source",
+          .label = "PCM file or named pipe",
+          .defaultText = "/tmp/fw16led-audio"},
+      PresetOptionConfig{
+          .type = PresetOptionType::NumberRange,
+          .key = "rate",
+          .label = "Sample rate (Hz)",
+          .minValue = 8000,
+          .maxValue = 96000,
+          .defaultNumber = 48000,
+          .isInteger = true},
+      PresetOptionConfig{
+          .type = PresetOptionType::NumberRange,
+          .key = "fps",
+          .label = "Frames per second",
+          .minValue = 30,
+          .maxValue = 60,
+          .defaultNumber = 60,
+          .isInteger = true},
+      PresetOptionConfig{
+          .type = PresetOptionType::Checkbox,
+          .key = "peaks",
+          .label = "Show peaks",
+          .defaultBool = true},
+  };
+
+  /**
+   * @brief Time constants of the bars rising to and falling back from a new level.
+   */
+  constexpr float ATTACK_TIME = 0.015f;
+  constexpr float DECAY_TIME = 0.25f;
+
+  /**
+   * @brief How long a peak stays put before it falls, and how fast it falls in levels per second.
+   */
+  constexpr auto PEAK_HOLD = std::chrono::milliseconds(600);
+  constexpr float PEAK_FALL_RATE = 1.5f;
+
+  /**
+   * @brief Analyses older than this are treated as silence, so the bars fall when the source stops.
+   */
+  constexpr auto STALE_AFTER = std::chrono::milliseconds(200);
+
+  /**
+   * @brief Longest time step of the smoothing, so the bars do not jump after a late tick.
+   */
+  constexpr float MAX_STEP = 0.1f;
+
+  Visualiser::Visualiser()
+    : Preset(ID, DISPLAY_NAME)
+  {
+  }
+
+  void Visualiser::init(std::shared_ptr<ledmatrix::LedMatrix> panel)
+  {
+    this->panel = panel;
+
+    auto source = getOptionValue<std::string>("source").value_or("");
+    auto rate = static_cast<int>(getOptionValue<double>("rate").value_or(48000));
+    capture = managers::AudioCapture::share(source, rate);
+
+    showPeaks = getOptionValue<bool>("peaks").value_or(true);
+    frameInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / getOptionValue<double>("fps").value_or(60)));
+    nextFrame.reset();
+    bars.fill(0.0f);
+    peaks.fill(0.0f);
+  }
+
+  void Visualiser::exit()
+  {
+    capture.reset();
+  }
+
+  std::optional<Preset::TimePoint> Visualiser::render(TimePoint now)
+  {
+    if (!nextFrame)
+    {
+      nextFrame = now;
+      lastFrame = now;
+    }
+    // Skip frames that were missed instead of falling behind
+    *nextFrame += frameInterval * ((now - *nextFrame) / frameInterval + 1);
+
+    auto analysis = capture->get_analysis();
+    if (analysis.sequence > 0 && now - analysis.time < STALE_AFTER)
+      targets = analysis.levels;
+    else
+      targets.fill(0.0f);
+
+    float step = std::min(std::chrono::duration<float>(now - lastFrame).count(), MAX_STEP);
+    lastFrame = now;
+    for (size_t band = 0; band < bars.size(); ++band)
+    {
+      float time = targets[band] > bars[band] ? ATTACK_TIME : DECAY_TIME;
+      bars[band] += (targets[band] - bars[band]) * (1.0f - std::exp(-step / time));
+
+      if (bars[band] >= peaks[band])
+      {
+        peaks[band] = bars[band];
+        peakHeldUntil[band] = now + PEAK_HOLD;
+      }
+      else if (now >= peakHeldUntil[band])
+      {
+        peaks[band] = std::max(bars[band], peaks[band] - PEAK_FALL_RATE * step);
+      }
+    }
+
+    draw();
+    return nextFrame;
+  }
+
+  void Visualiser::draw()
+  {
+    auto height = [](float level)
+    { return static_cast<int>(std::lround(std::clamp(level, 0.0f, 1.0f) * ledmatrix::HEIGHT)); };
+
+    if (!showPeaks)
+    {
+      std::array<uint8_t, managers::Spectrum::BANDS> heights{};
+      for (size_t band = 0; band < bars.size(); ++band)
+        heights[band] = static_cast<uint8_t>(height(bars[band]));
+      panel->pattern_equalizer(heights);
+      return;
+    }
+
+    // Bars centred like pattern_equalizer() draws them, with a pixel above and below for the peak
+    ledmatrix::MatrixBitmap bitmap;
+    for (int band = 0; band < static_cast<int>(bars.size()); ++band)
+    {
+      int bar = height(bars[band]);
+      bitmap.fill_rect(band, ledmatrix::HEIGHT / 2 - (bar - bar / 2), 1, bar);
+
+      int peak = height(peaks[band]);
+      if (peak > bar)
+      {
+        bitmap.set(band, ledmatrix::HEIGHT / 2 - (peak - peak / 2));
+        bitmap.set(band, ledmatrix::HEIGHT / 2 + peak / 2 - 1);
+      }
+    }
+    panel->pattern_matrix(bitmap);
+  }
+
+  void Visualiser::registerPreset(std::shared_ptr<PresetRegistry> registry)
+  {
+    registry->registerPreset(ID, DISPLAY_NAME, []()
+                             { return std::make_unique<fw16led::presets::Visualiser>(); }, SETTINGS);
+  }
+} // namespace fw16led::presets
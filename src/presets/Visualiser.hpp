@@ -0,0 +1,40 @@
+#pragma once
+
+#include "fw16led/Preset.hpp"
+#include "fw16led/PresetRegistry.hpp"
+#include "fw16led/managers/audio.hpp"
+#include <array>
+#include <memory>
+
+namespace fw16led::presets
+{
+  /**
+   * @brief Shows the spectrum of an audio source as nine bars with falling peaks.
+   */
+  class Visualiser : public Preset
+  {
+  public:
+    Visualiser();
+    virtual ~Visualiser() = default;
+    void init(std::shared_ptr<ledmatrix::LedMatrix> panel) override;
+    void exit() override;
+    std::optional<TimePoint> render(TimePoint now) override;
+    static void registerPreset(std::shared_ptr<PresetRegistry> registry);
+
+  private:
+    void draw();
+
+    std::shared_ptr<ledmatrix::LedMatrix> panel;
+    std::shared_ptr<managers::AudioCapture> capture;
+    bool showPeaks = true;
+    std::chrono::steady_clock::duration frameInterval{};
+    std::optional<TimePoint> nextFrame;
+    TimePoint lastFrame;
+
+    managers::Spectrum::Levels targets{}; /**< Levels of the latest analysis. */
+    managers::Spectrum::Levels bars{};    /**< Shown levels, following the targets with attack and decay. */
+    managers::Spectrum::Levels peaks{};
+    std::array<TimePoint, managers::Spectrum::BANDS> peakHeldUntil{};
+  };
+
+} // namespace fw16led::presets
@@ -1,6 +1,7 @@
 #include "MainWindow.hpp"
 
 #include "SettingsTab.hpp"
+#include "StatsTab.hpp"
 #include "fw16led/global.hpp"
 #include "fw16led/managers/usb.hpp"
 #include <QCloseEvent>
@@ -16,20 +17,56 @@ namespace fw16led::ui
     setIconSize(QSize(64, 64));
     resize(800, 600);
 
-    QTabWidget* tabWidget = new QTabWidget(this);
+    tabWidget = new QTabWidget(this);
     setCentralWidget(tabWidget);
 
+    // Panel tabs are inserted in front of the statistics
+    tabWidget->addTab(new StatsTab(), "Statistics");
+
     for (auto panel : usb_manager->get_ledpanels())
     {
-      uint8_t id = panel->getId();
-      tabWidget->addTab(new SettingsTab(id), QString("Panel %1").arg(id));
+      addPanelTab(panel->getId());
     }
 
+    // Panels come and go while the application is running
+    usb_manager->onPanelAdded([this](std::shared_ptr<LedPanel> panel)
+                              { addPanelTab(panel->getId()); });
+    usb_manager->onPanelRemoved([this](std::shared_ptr<LedPanel> panel)
+                                { removePanelTab(panel->getId()); });
+
     // Ensure tabs fill the window
     tabWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     tabWidget->setTabPosition(QTabWidget::North);
   }
 
+  void MainWindow::addPanelTab(uint8_t panelId)
+  {
+    // Keep the tabs sorted by panel id
+    int index = 0;
+    while (index < tabWidget->count())
+    {
+      auto* tab = qobject_cast<SettingsTab*>(tabWidget->widget(index));
+      if (!tab || tab->getPanelId() >= panelId)
+        break;
+      index++;
+    }
+    tabWidget->insertTab(index, new SettingsTab(panelId), QString("Panel %1").arg(panelId));
+  }
+
+  void MainWindow::removePanelTab(uint8_t panelId)
+  {
+    for (int i = 0; i < tabWidget->count(); i++)
+    {
+      auto* tab = qobject_cast<SettingsTab*>(tabWidget->widget(i));
+      if (tab && tab->getPanelId() == panelId)
+      {
+        tabWidget->removeTab(i);
+        tab->deleteLater();
+        return;
+      }
+    }
+  }
+
   void MainWindow::closeEvent(QCloseEvent* event)
   {
     if (trayIcon->isVisible())
@@ -2,6 +2,8 @@
 
 #include <QMainWindow>
 #include <QSystemTrayIcon>
+#include <QTabWidget>
+#include <cstdint>
 
 namespace fw16led::ui
 {
@@ -14,6 +16,12 @@ namespace fw16led::ui
   protected:
     void closeEvent(QCloseEvent* event) override;
 
+  private:
+    void addPanelTab(uint8_t panelId);
+    void removePanelTab(uint8_t panelId);
+
+    QTabWidget* tabWidget;
+
   public:
     QSystemTrayIcon* trayIcon;
   };
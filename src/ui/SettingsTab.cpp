@@ -41,7 +41,7 @@ namespace fw16led::ui
     QLabel* presetLabel = new QLabel("Preset: ", this);
     presetComboBox = new QComboBox(this);
     connect(presetComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SettingsTab::onPresetChanged);
-    for (const auto preset : preset_registry->getRegisteredPresetIds())
+    for (const auto& preset : preset_registry->getRegisteredPresetIds())
     {
       QString presetName = QString::fromStdString(preset_registry->getDisplayName(preset));
       QString presetId = QString::fromStdString(preset);
@@ -174,7 +174,7 @@ namespace fw16led::ui
     clearLayout(dynamicSettingsLayout);
 
     // Get the preset options
-    auto options = preset_registry->getOptions(presetKey.toStdString());
+    const auto& options = preset_registry->getOptions(presetKey.toStdString());
 
     for (const auto& option : options)
     {
@@ -18,6 +18,8 @@ namespace fw16led::ui
     SettingsTab(uint8_t panelId);
     void reset();
 
+    inline uint8_t getPanelId() const { return panelId; }
+
   private:
     void apply();
     void onPresetChanged(int index);
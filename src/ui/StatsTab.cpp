@@ -0,0 +1,128 @@
+#include "StatsTab.hpp"
+#include "fw16led/global.hpp"
+#include "fw16led/managers/metrics.hpp"
+#include "fw16led/managers/usb.hpp"
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <chrono>
+
+namespace fw16led::ui
+{
+  inline constexpr auto REFRESH_INTERVAL = std::chrono::seconds(1);
+
+  /**
+   * @brief Role of the item data holding the key used to remember whether an item is expanded.
+   */
+  inline constexpr int KEY_ROLE = Qt::UserRole;
+
+  StatsTab::StatsTab()
+  {
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+
+    tree = new QTreeWidget(this);
+    tree->setColumnCount(2);
+    tree->setHeaderLabels({"Metric", "Value"});
+    tree->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+    connect(tree, &QTreeWidget::itemCollapsed, this, [this](QTreeWidgetItem* item)
+            {
+              auto key = item->data(0, KEY_ROLE).toString();
+              if (item->parent())
+                expandedBreakdowns.remove(key);
+              else
+                collapsedPanels.insert(key); });
+    connect(tree, &QTreeWidget::itemExpanded, this, [this](QTreeWidgetItem* item)
+            {
+              auto key = item->data(0, KEY_ROLE).toString();
+              if (item->parent())
+                expandedBreakdowns.insert(key);
+              else
+                collapsedPanels.remove(key); });
+    mainLayout->addWidget(tree);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    QPushButton* saveButton = new QPushButton("Save as JSON...", this);
+    connect(saveButton, &QPushButton::clicked, this, &StatsTab::saveJson);
+    buttonLayout->addWidget(saveButton);
+    mainLayout->addLayout(buttonLayout);
+
+    refreshTimer = new QTimer(this);
+    connect(refreshTimer, &QTimer::timeout, this, &StatsTab::refresh);
+  }
+
+  void StatsTab::showEvent(QShowEvent* event)
+  {
+    QWidget::showEvent(event);
+    refresh();
+    refreshTimer->start(REFRESH_INTERVAL);
+  }
+
+  void StatsTab::hideEvent(QHideEvent* event)
+  {
+    QWidget::hideEvent(event);
+    refreshTimer->stop();
+  }
+
+  void StatsTab::refresh()
+  {
+    // The tree is rebuilt from scratch, the expanded state is restored from the keys
+    tree->setUpdatesEnabled(false);
+    tree->blockSignals(true);
+    tree->clear();
+
+    auto addRow = [](QTreeWidgetItem* parent, const QString& name, const QString& value)
+    {
+      return new QTreeWidgetItem(parent, {name, value});
+    };
+
+    for (const auto& panel : usb_manager->get_ledpanels())
+    {
+      auto matrix = panel->getLedMatrix();
+      auto metrics = matrix->get_metrics();
+      const auto& transport = metrics.transport;
+
+      auto panelKey = QString("panel_%1").arg(panel->getId());
+      auto* item = new QTreeWidgetItem(tree, {QString("Panel %1").arg(panel->getId()), matrix->is_connected() ? "connected" : "disconnected"});
+      item->setData(0, KEY_ROLE, panelKey);
+
+      addRow(item, "Packets sent", QString::number(transport.packetsSent));
+      addRow(item, "Bytes sent", QString::number(transport.bytesSent));
+      addRow(item, "Retries", QString::number(transport.retries));
+      addRow(item, "Timeouts", QString::number(transport.timeouts));
+      addRow(item, "Failed commands", QString::number(transport.failures));
+      addRow(item, "Frames sent", QString::number(metrics.frames.sent));
+      addRow(item, "Frames elided", QString::number(metrics.frames.elided));
+      addRow(item, "Command latency", transport.latency.count() == 0 ? QString("-") : QString("p50 < %1 us, p90 < %2 us, p99 < %3 us").arg(transport.latency.percentile(0.5).count()).arg(transport.latency.percentile(0.9).count()).arg(transport.latency.percentile(0.99).count()));
+
+      auto* commands = addRow(item, "Commands", "");
+      commands->setData(0, KEY_ROLE, panelKey + "_commands");
+      for (size_t i = 0; i < ledmatrix::COMMAND_COUNT; ++i)
+      {
+        if (transport.commandsSent[i] > 0)
+          addRow(commands, ledmatrix::command_name(static_cast<ledmatrix::Command>(i)), QString::number(transport.commandsSent[i]));
+      }
+
+      item->setExpanded(!collapsedPanels.contains(panelKey));
+      commands->setExpanded(expandedBreakdowns.contains(panelKey + "_commands"));
+    }
+
+    tree->blockSignals(false);
+    tree->setUpdatesEnabled(true);
+  }
+
+  void StatsTab::saveJson()
+  {
+    QString path = QFileDialog::getSaveFileName(this, "Save metrics", "fw16led-metrics.json", "JSON (*.json)");
+    if (path.isEmpty())
+      return;
+
+    if (!managers::writeMetrics(path, usb_manager->get_ledpanels(), usb_manager->getSpanStats()))
+    {
+      QMessageBox::warning(this, "Save metrics", QString("Could not write %1").arg(path));
+    }
+  }
+} // namespace fw16led::ui
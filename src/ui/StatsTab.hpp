@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QWidget>
+
+namespace fw16led::ui
+{
+  /**
+   * @brief Live view of the transport metrics of all panels.
+   *
+   * Refreshes once per second while it is visible, and can save the metrics as JSON.
+   */
+  class StatsTab : public QWidget
+  {
+    Q_OBJECT
+  public:
+    StatsTab();
+
+  protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+  private:
+    void refresh();
+    void saveJson();
+
+    QTreeWidget* tree;
+    QTimer* refreshTimer;
+    QSet<QString> collapsedPanels;    /**< Panels are expanded unless the user collapsed them. */
+    QSet<QString> expandedBreakdowns; /**< Per-command breakdowns are collapsed unless the user expanded them. */
+  };
+} // namespace fw16led::ui